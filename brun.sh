@@ -5,6 +5,6 @@
 mkdir -p build
 
 pushd build
-g++ -o frag ../code/*.cpp ../code/libs/glad.c -I../code/include `pkg-config --libs glfw3` -ldl\
+g++ -o frag ../code/*.cpp ../code/libs/glad.c -I../code/include `pkg-config --libs glfw3` -lEGL -ldl -pthread\
     && ./frag
 popd
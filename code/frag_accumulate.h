@@ -0,0 +1,227 @@
+// NOTE(Jovan): Progressive accumulation. The shader draws one sample per
+// frame into a float target, a blend pass folds it into the running mean,
+// ping-ponging between two accumulation targets, and the mean is what ends
+// up on screen. The blend also keeps the mean of the squared luminance, which
+// gives each pixel's standard error; their average is the noise estimate.
+// Time is held while accumulating, a change in anything else the program
+// reads, the program itself or the window size starts over. Once the sample
+// target or noise threshold is reached the shader isn't drawn anymore. The
+// noise comes back through a pixel buffer, so it's always one measurement
+// behind
+
+#define ACCUMULATE_DEFAULT_SAMPLES 1024
+#define ACCUMULATE_DEFAULT_NOISE 0.005
+#define ACCUMULATE_NOISE_INTERVAL 16
+
+global const char *ACCUMULATE_FRAGMENT_SOURCE = R"(#version 330 core
+uniform sampler2D Previous;
+uniform sampler2D Sample;
+uniform float SampleCount;
+layout(location = 0) out vec4 Mean;
+layout(location = 1) out float Error;
+
+void main() {
+    ivec2 P = ivec2(gl_FragCoord.xy);
+    vec4 Accumulated = texelFetch(Previous, P, 0);
+    vec3 Color = texelFetch(Sample, P, 0).rgb;
+    float Luminance = dot(Color, vec3(0.2126, 0.7152, 0.0722));
+    // NOTE(Jovan): The first sample mustn't touch whatever the fresh texture held
+    Mean = SampleCount > 1.0 ? mix(Accumulated, vec4(Color, Luminance * Luminance), 1.0 / SampleCount)
+                             : vec4(Color, Luminance * Luminance);
+
+    float MeanLuminance = dot(Mean.rgb, vec3(0.2126, 0.7152, 0.0722));
+    float Variance = max(Mean.a - MeanLuminance * MeanLuminance, 0.0);
+    Error = SampleCount > 1.0 ? sqrt(Variance / SampleCount) / max(MeanLuminance, 0.05) : 1.0;
+}
+)";
+
+struct accumulator {
+    b32 Enabled;
+    u32 TargetSamples;
+    r64 NoiseThreshold;
+
+    u32 BlendProgram;
+    i32 SampleCountLocation;
+    u32 SampleFramebuffer;
+    u32 SampleTexture;
+    u32 Framebuffers[2];
+    u32 Textures[2];
+    u32 ErrorTexture;
+    u32 ErrorFramebuffer;
+    frame_readback NoiseReadback;
+    u32 Current;
+    i32 Width;
+    i32 Height;
+
+    u32 ProgramID;
+    u32 Run;
+    u32 Samples;
+    r64 Noise;
+    b32 Converged;
+};
+
+internal void
+_TakeAccumulationNoise(void *user, u32 run, const u8 *pixels, i32, i32) {
+    accumulator *Acc = (accumulator*)user;
+    if(run == Acc->Run) {
+        Acc->Noise = *(const r32*)pixels;
+    }
+}
+
+internal void
+InitAccumulator(accumulator *acc) {
+    acc->BlendProgram = BuildFullscreenProgram(ACCUMULATE_FRAGMENT_SOURCE, "accumulate");
+    if(acc->BlendProgram) {
+        glUseProgram(acc->BlendProgram);
+        glUniform1i(glGetUniformLocation(acc->BlendProgram, "Previous"), 0);
+        glUniform1i(glGetUniformLocation(acc->BlendProgram, "Sample"), 1);
+        acc->SampleCountLocation = glGetUniformLocation(acc->BlendProgram, "SampleCount");
+    }
+    glGenFramebuffers(1, &acc->SampleFramebuffer);
+    glGenTextures(1, &acc->SampleTexture);
+    glGenFramebuffers(2, acc->Framebuffers);
+    glGenTextures(2, acc->Textures);
+    glGenTextures(1, &acc->ErrorTexture);
+    glGenFramebuffers(1, &acc->ErrorFramebuffer);
+    InitFrameReadback(&acc->NoiseReadback, 1, 1, 1, _TakeAccumulationNoise, acc, GL_RED, GL_FLOAT);
+}
+
+internal void
+AllocateAccumulationTexture(u32 texture, GLenum format, i32 width, i32 height) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format == GL_R32F ? GL_RED : GL_RGBA, GL_FLOAT, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+internal void
+ResizeAccumulator(accumulator *acc, i32 width, i32 height) {
+    acc->Width = width;
+    acc->Height = height;
+    AllocateAccumulationTexture(acc->SampleTexture, GL_RGBA32F, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, acc->SampleFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, acc->SampleTexture, 0);
+
+    AllocateAccumulationTexture(acc->ErrorTexture, GL_R32F, width, height);
+    GLenum DrawBuffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    for(u32 Index = 0; Index < 2; ++Index) {
+        AllocateAccumulationTexture(acc->Textures[Index], GL_RGBA32F, width, height);
+        glBindFramebuffer(GL_FRAMEBUFFER, acc->Framebuffers[Index]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, acc->Textures[Index], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, acc->ErrorTexture, 0);
+        glDrawBuffers(2, DrawBuffers);
+    }
+
+    // NOTE(Jovan): The last mip level is the average error over the image,
+    // only one float comes back
+    i32 Level = (i32)floor(log2((r64)std::max(width, height)));
+    glBindFramebuffer(GL_FRAMEBUFFER, acc->ErrorFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, acc->ErrorTexture, Level);
+}
+
+internal void
+ResetAccumulation(accumulator *acc) {
+    ++acc->Run;
+    acc->Samples = 0;
+    acc->Noise = 1.0;
+    acc->Converged = false;
+}
+
+// NOTE(Jovan): Call with the program bound and its uniforms reflected but not
+// uploaded yet. Returns true when a new sample should be drawn, the sample
+// target is bound in that case
+internal b32
+BeginAccumulationFrame(accumulator *acc, u32 programID, const uniform_table *table,
+                       const standard_uniforms *inputs, i32 width, i32 height) {
+    if(!acc->BlendProgram) {
+        return false;
+    }
+    if(acc->Width != width || acc->Height != height) {
+        ResizeAccumulator(acc, width, height);
+        ResetAccumulation(acc);
+    }
+    if(acc->ProgramID != programID) {
+        acc->ProgramID = programID;
+        ResetAccumulation(acc);
+    }
+    for(u32 Handle = 0; Handle < table->Slots.size(); ++Handle) {
+        const uniform_slot *Slot = &table->Slots[Handle];
+        if(Handle != inputs->Time && Handle != inputs->Frame && Slot->Location >= 0 && Slot->Dirty) {
+            ResetAccumulation(acc);
+            break;
+        }
+    }
+
+    if(acc->Converged) {
+        return false;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, acc->SampleFramebuffer);
+    glClear(GL_COLOR_BUFFER_BIT);
+    return true;
+}
+
+// NOTE(Jovan): Only one measurement is in flight, one that isn't back yet
+// by the next interval just makes that one get skipped
+internal void
+MeasureAccumulationNoise(accumulator *acc) {
+    if(acc->NoiseReadback.PendingCount) {
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, acc->ErrorTexture);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, acc->ErrorFramebuffer);
+    QueueFrameReadback(&acc->NoiseReadback, acc->Run);
+}
+
+// NOTE(Jovan): Blends the sample in if one was drawn, then shows the mean
+internal void
+EndAccumulationFrame(accumulator *acc, b32 drew, u32 vao) {
+    if(drew) {
+        u32 Previous = acc->Current;
+        acc->Current ^= 1;
+        ++acc->Samples;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, acc->Framebuffers[acc->Current]);
+        glUseProgram(acc->BlendProgram);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, acc->Textures[Previous]);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, acc->SampleTexture);
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1f(acc->SampleCountLocation, (r32)acc->Samples);
+        glBindVertexArray(vao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        DeliverOldestReadback(&acc->NoiseReadback, false);
+        if(acc->Samples % ACCUMULATE_NOISE_INTERVAL == 0) {
+            MeasureAccumulationNoise(acc);
+        }
+        if(acc->Samples >= acc->TargetSamples || acc->Noise <= acc->NoiseThreshold) {
+            acc->Converged = true;
+            char Line[128];
+            snprintf(Line, sizeof(Line), "Converged after %u samples, noise %.4f", acc->Samples, acc->Noise);
+            std::cout << "[Info] Accumulate: " << Line << std::endl;
+        }
+    }
+    if(!acc->Samples) {
+        return;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, acc->Framebuffers[acc->Current]);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, acc->Width, acc->Height, 0, 0, acc->Width, acc->Height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+internal void
+ShutdownAccumulator(accumulator *acc) {
+    if(acc->BlendProgram) glDeleteProgram(acc->BlendProgram);
+    glDeleteFramebuffers(1, &acc->SampleFramebuffer);
+    glDeleteTextures(1, &acc->SampleTexture);
+    glDeleteFramebuffers(2, acc->Framebuffers);
+    glDeleteTextures(2, acc->Textures);
+    glDeleteTextures(1, &acc->ErrorTexture);
+    glDeleteFramebuffers(1, &acc->ErrorFramebuffer);
+    ShutdownFrameReadback(&acc->NoiseReadback);
+}
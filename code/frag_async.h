@@ -0,0 +1,340 @@
+// NOTE(Jovan): Non-blocking program builds. Compile and link are issued right
+// away and the status is only queried once the driver reports completion
+// through KHR/ARB_parallel_shader_compile. Without the extension the query
+// is deferred a couple of frames so the driver still gets a head start.
+// With a compile worker everything happens on its context instead and the
+// queue only polls the fences it hands back
+
+#define COMPILE_DEFER_FRAMES 2
+
+enum compile_status {
+    CompileStatus_None,
+    CompileStatus_Pending,
+    CompileStatus_Done,
+    CompileStatus_Failed,
+};
+
+struct compile_job {
+    u32 Handle;
+    compile_status Status;
+    shader_program Program;
+    u32 VertexID;
+    u32 FragmentID;
+    u64 CacheKey;
+    u32 FramesWaited;
+    GLsync Fence;
+};
+
+struct compile_queue {
+    b32 ParallelCompile;
+    compile_worker *Worker;
+    u32 NextHandle;
+    std::vector<compile_job> Jobs;
+};
+
+internal void
+InitCompileQueue(compile_queue *queue, compile_worker *worker = 0) {
+    queue->NextHandle = 1;
+    queue->Worker = worker;
+    if(worker) {
+        std::cout << "[Info] Compile: Building programs on a background context" << std::endl;
+        return;
+    }
+
+    queue->ParallelCompile = GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+
+    // NOTE(Jovan): 0xFFFFFFFF lets the driver pick as many threads as it likes
+    if(GLAD_GL_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    } else if(GLAD_GL_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    }
+
+    std::cout << "[Info] Compile: " << (queue->ParallelCompile ? "Parallel shader compile available" :
+                                        "No parallel shader compile, deferring status checks") << std::endl;
+}
+
+internal compile_job*
+FindCompileJob(compile_queue *queue, u32 handle) {
+    for(compile_job &Job : queue->Jobs) {
+        if(Job.Handle == handle) {
+            return &Job;
+        }
+    }
+    return 0;
+}
+
+internal void
+ReleaseCompileObjects(compile_job *job) {
+    if(job->VertexID) glDeleteShader(job->VertexID);
+    if(job->FragmentID) glDeleteShader(job->FragmentID);
+    job->VertexID = job->FragmentID = 0;
+}
+
+internal u32
+BeginCompileProgram(compile_queue *queue, const shader_program *program) {
+    compile_job Job = {};
+    Job.Handle = queue->NextHandle++;
+    Job.Status = CompileStatus_Pending;
+    Job.Program = *program;
+    Job.Program.ID = 0;
+    Job.Program.PendingBuild = 0;
+
+    if(queue->Worker) {
+        PushWorkerJob(queue->Worker, Job.Handle, program);
+        queue->Jobs.push_back(Job);
+        return Job.Handle;
+    }
+
+    if(G_PROGRAM_CACHE.Enabled) {
+        Job.CacheKey = ShaderProgramCacheKey(program);
+        Job.Program.ID = LoadCachedProgram(&G_PROGRAM_CACHE, Job.CacheKey);
+        if(Job.Program.ID) {
+            Job.Status = CompileStatus_Done;
+            queue->Jobs.push_back(Job);
+            return Job.Handle;
+        }
+    }
+
+    Job.VertexID = BeginShaderStage(&program->Vertex, GL_VERTEX_SHADER);
+    Job.FragmentID = BeginShaderStage(&program->Fragment, GL_FRAGMENT_SHADER);
+
+    // NOTE(Jovan): Linking right away without looking at the compile status,
+    // a failed compile just shows up as a failed link later on. Libraries
+    // are the same, an edited one is only issued here and checked once the
+    // link is done
+    Job.Program.ID = glCreateProgram();
+    glAttachShader(Job.Program.ID, Job.VertexID);
+    glAttachShader(Job.Program.ID, Job.FragmentID);
+    AttachLibraryShaders(Job.Program.ID, &program->Vertex, GL_VERTEX_SHADER, false);
+    AttachLibraryShaders(Job.Program.ID, &program->Fragment, GL_FRAGMENT_SHADER, false);
+    if(G_PROGRAM_CACHE.Enabled) {
+        glProgramParameteri(Job.Program.ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(Job.Program.ID);
+
+    queue->Jobs.push_back(Job);
+    return Job.Handle;
+}
+
+internal void
+FinishCompileJob(compile_job *job) {
+    i32 Success = 0;
+    glGetProgramiv(job->Program.ID, GL_LINK_STATUS, &Success);
+    if(!Success) {
+        i32 VertexOk = 0, FragmentOk = 0;
+        glGetShaderiv(job->VertexID, GL_COMPILE_STATUS, &VertexOk);
+        glGetShaderiv(job->FragmentID, GL_COMPILE_STATUS, &FragmentOk);
+        if(!VertexOk) {
+            PrintShaderLog(job->VertexID, GL_VERTEX_SHADER, job->Program.VertexPath, &job->Program.Vertex.Files);
+        }
+        if(!FragmentOk) {
+            PrintShaderLog(job->FragmentID, GL_FRAGMENT_SHADER, job->Program.FragmentPath, &job->Program.Fragment.Files);
+        }
+        // NOTE(Jovan): A library that failed says so once per edit, not
+        // once for every program linked against it
+        b32 LibrariesOk = CheckLibraryShaders(&job->Program.Vertex, GL_VERTEX_SHADER) &
+                          CheckLibraryShaders(&job->Program.Fragment, GL_FRAGMENT_SHADER);
+        if(VertexOk && FragmentOk && LibrariesOk) PrintProgramLog(job->Program.ID);
+
+        glDeleteProgram(job->Program.ID);
+        job->Program.ID = 0;
+        job->Status = CompileStatus_Failed;
+    } else {
+        DetachShaders(job->Program.ID);
+        if(G_PROGRAM_CACHE.Enabled) {
+            StoreCachedProgram(&G_PROGRAM_CACHE, job->CacheKey, job->Program.ID);
+        }
+        job->Status = CompileStatus_Done;
+    }
+
+    ReleaseCompileObjects(job);
+}
+
+internal void
+UpdateWorkerJobs(compile_queue *queue) {
+    for(worker_job &Finished : PollWorkerJobs(queue->Worker)) {
+        compile_job *Job = FindCompileJob(queue, Finished.Handle);
+        if(!Job) {
+            // NOTE(Jovan): Cancelled while the worker was busy with it
+            if(Finished.Fence) glDeleteSync(Finished.Fence);
+            if(Finished.Program.ID) glDeleteProgram(Finished.Program.ID);
+            continue;
+        }
+
+        Job->Program.ID = Finished.Program.ID;
+        Job->Fence = Finished.Fence;
+        if(!Job->Program.ID) {
+            Job->Status = CompileStatus_Failed;
+        }
+    }
+
+    for(compile_job &Job : queue->Jobs) {
+        if(Job.Status != CompileStatus_Pending || !Job.Fence) {
+            continue;
+        }
+
+        GLenum Result = glClientWaitSync(Job.Fence, 0, 0);
+        if(Result == GL_ALREADY_SIGNALED || Result == GL_CONDITION_SATISFIED) {
+            glDeleteSync(Job.Fence);
+            Job.Fence = 0;
+            Job.Status = CompileStatus_Done;
+        }
+    }
+}
+
+// NOTE(Jovan): Whether there are jobs the frame loop has to keep polling,
+// ones still sitting on the worker wake it up once they're done
+internal b32
+CompileQueueBusy(const compile_queue *queue) {
+    for(const compile_job &Job : queue->Jobs) {
+        if(Job.Status == CompileStatus_Pending && (!queue->Worker || Job.Fence)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// NOTE(Jovan): Called once per frame, never blocks when the extension is there
+internal void
+UpdateCompileQueue(compile_queue *queue) {
+    if(queue->Worker) {
+        UpdateWorkerJobs(queue);
+        return;
+    }
+
+    for(compile_job &Job : queue->Jobs) {
+        if(Job.Status != CompileStatus_Pending) {
+            continue;
+        }
+
+        if(queue->ParallelCompile) {
+            i32 Completed = 0;
+            glGetProgramiv(Job.Program.ID, GL_COMPLETION_STATUS_KHR, &Completed);
+            if(!Completed) {
+                continue;
+            }
+        } else if(Job.FramesWaited++ < COMPILE_DEFER_FRAMES) {
+            continue;
+        }
+
+        FinishCompileJob(&Job);
+    }
+}
+
+internal compile_status
+GetCompileStatus(compile_queue *queue, u32 handle) {
+    compile_job *Job = FindCompileJob(queue, handle);
+    return Job ? Job->Status : CompileStatus_None;
+}
+
+internal void
+RemoveCompileJob(compile_queue *queue, u32 handle) {
+    for(size_t JobIndex = 0; JobIndex < queue->Jobs.size(); ++JobIndex) {
+        if(queue->Jobs[JobIndex].Handle == handle) {
+            queue->Jobs.erase(queue->Jobs.begin() + JobIndex);
+            return;
+        }
+    }
+}
+
+// NOTE(Jovan): Hands the finished program over to the caller and forgets the job
+internal b32
+TakeCompiledProgram(compile_queue *queue, u32 handle, shader_program *out) {
+    compile_job *Job = FindCompileJob(queue, handle);
+    if(!Job || Job->Status != CompileStatus_Done) {
+        return false;
+    }
+
+    *out = Job->Program;
+    RemoveCompileJob(queue, handle);
+    return true;
+}
+
+internal void
+CancelCompileJob(compile_queue *queue, u32 handle) {
+    compile_job *Job = FindCompileJob(queue, handle);
+    if(!Job) {
+        return;
+    }
+
+    if(queue->Worker) {
+        RemoveWorkerJob(queue->Worker, handle);
+    }
+    ReleaseCompileObjects(Job);
+    if(Job->Fence) {
+        glDeleteSync(Job->Fence);
+    }
+    if(Job->Program.ID) {
+        glDeleteProgram(Job->Program.ID);
+    }
+    RemoveCompileJob(queue, handle);
+}
+
+internal void
+RequestProgramBuild(compile_queue *queue, shader_program *program) {
+    if(program->PendingBuild) {
+        CancelCompileJob(queue, program->PendingBuild);
+    }
+    program->PendingBuild = BeginCompileProgram(queue, program);
+}
+
+// NOTE(Jovan): Only programs whose include graph reaches one of the changed
+// files get preprocessed and rebuilt, everything else is left alone
+internal b32
+RequestProgramReload(compile_queue *queue, shader_preprocessor *pp, shader_program *program,
+                     const std::vector<std::string> &changed) {
+    if(!ShaderProgramDependsOn(program, changed)) {
+        return false;
+    }
+
+    if(!PreprocessShaderProgram(pp, program)) {
+        std::cerr << "[Err] Shader: Preprocessing " << program->FragmentPath << " failed"
+                  << (program->ID ? ", keeping previous program" : "") << std::endl;
+        return false;
+    }
+
+    RequestProgramBuild(queue, program);
+    return true;
+}
+
+// NOTE(Jovan): Returns true when a freshly built program got swapped in
+internal b32
+UpdateProgramBuild(compile_queue *queue, shader_program *program) {
+    if(!program->PendingBuild) {
+        return false;
+    }
+
+    shader_program Built;
+    switch(GetCompileStatus(queue, program->PendingBuild)) {
+        case CompileStatus_Pending: {
+            return false;
+        }
+        case CompileStatus_Done: {
+            TakeCompiledProgram(queue, program->PendingBuild, &Built);
+            if(program->ID) {
+                glDeleteProgram(program->ID);
+            }
+            program->ID = Built.ID;
+            program->Build = ++G_PROGRAM_BUILDS;
+            program->PendingBuild = 0;
+            RegisterSpirvUniforms(Built.ID, &Built.Vertex, &Built.Fragment);
+            std::cout << "[Info] Shader: Built " << program->FragmentPath << std::endl;
+            return true;
+        }
+        default: {
+            std::cerr << "[Err] Shader: Build of " << program->FragmentPath << " failed"
+                      << (program->ID ? ", keeping previous program" : "") << std::endl;
+            RemoveCompileJob(queue, program->PendingBuild);
+            program->PendingBuild = 0;
+            return false;
+        }
+    }
+}
+
+internal void
+ShutdownCompileQueue(compile_queue *queue) {
+    while(!queue->Jobs.empty()) {
+        CancelCompileJob(queue, queue->Jobs.back().Handle);
+    }
+}
@@ -0,0 +1,285 @@
+// NOTE(Jovan): --compile-only mode. Compiles every stage under a directory,
+// each permutation on its own, spread over worker threads that each own a
+// headless context. Software drivers compile on the calling thread so this is
+// what gets llvmpipe onto every core. Results go to stdout as JSON lines
+
+struct batch_job {
+    std::string Path;
+    GLuint Type;
+    u32 Key;
+    std::string Variant;
+    preprocessed_source Source;
+};
+
+struct batch_result {
+    b32 Success;
+    r64 Milliseconds;
+    std::string Log;
+};
+
+struct batch_compile {
+    std::vector<batch_job> Jobs;
+    std::vector<batch_result> Results;
+    std::atomic<u32> NextJob;
+};
+
+internal GLuint
+ShaderTypeFromPath(const std::string &path) {
+    size_t Dot = path.find_last_of('.');
+    std::string Extension = Dot == std::string::npos ? "" : path.substr(Dot + 1);
+    if(Extension == "vert") return GL_VERTEX_SHADER;
+    if(Extension == "frag") return GL_FRAGMENT_SHADER;
+    if(Extension == "geom") return GL_GEOMETRY_SHADER;
+    return 0;
+}
+
+internal std::string
+JsonEscape(const std::string &str) {
+    std::string Result;
+    Result.reserve(str.size() + 2);
+    for(char C : str) {
+        switch(C) {
+            case '"': Result += "\\\""; break;
+            case '\\': Result += "\\\\"; break;
+            case '\n': Result += "\\n"; break;
+            case '\r': Result += "\\r"; break;
+            case '\t': Result += "\\t"; break;
+            default: {
+                if((u8)C < 0x20) {
+                    char Escaped[8];
+                    snprintf(Escaped, sizeof(Escaped), "\\u%04x", (u8)C);
+                    Result += Escaped;
+                } else {
+                    Result += C;
+                }
+            }
+        }
+    }
+    return Result;
+}
+
+internal r64
+MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<r64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// NOTE(Jovan): Preprocessing is cheap next to compiling, so it happens up
+// front on the main thread and the workers only ever touch GL
+internal void
+CollectBatchJobs(batch_compile *batch, shader_preprocessor *pp, const std::vector<std::string> &paths) {
+    for(const std::string &Path : paths) {
+        batch_job Job;
+        Job.Path = Path;
+        Job.Type = ShaderTypeFromPath(Path);
+        Job.Key = 0;
+        if(!PreprocessShader(pp, Path, &Job.Source)) {
+            batch_result Failed = {false, 0.0, pp->LastError};
+            batch->Jobs.push_back(Job);
+            batch->Results.push_back(Failed);
+            continue;
+        }
+
+        variant_set Set = {};
+        Set.Axes = Job.Source.Variants;
+        Set.KeyBits = LayoutVariantAxes(Set.Axes);
+        for(u32 Key = 0; Key < (1u << Set.KeyBits); ++Key) {
+            if(!IsValidVariantKey(&Set, Key)) {
+                continue;
+            }
+            batch_job Variant;
+            Variant.Path = Path;
+            Variant.Type = Job.Type;
+            Variant.Key = Key;
+            Variant.Variant = Set.Axes.empty() ? "" : VariantKeyName(&Set, Key);
+            Variant.Source = InjectVariantDefines(Job.Source, VariantDefines(&Set, Key));
+            batch->Jobs.push_back(std::move(Variant));
+            batch->Results.push_back({false, -1.0, ""});
+        }
+    }
+}
+
+internal void
+_BatchWorker(batch_compile *batch, egl_device *device, egl_context *context) {
+    if(!MakeHeadlessContextCurrent(device, context)) {
+        std::cerr << "[Err] Batch: Failed making a worker context current" << std::endl;
+        return;
+    }
+
+    for(u32 JobIndex = batch->NextJob++; JobIndex < batch->Jobs.size(); JobIndex = batch->NextJob++) {
+        batch_job *Job = &batch->Jobs[JobIndex];
+        batch_result *Result = &batch->Results[JobIndex];
+        if(Result->Milliseconds >= 0.0) {
+            continue;
+        }
+
+        // NOTE(Jovan): There's no program to link libraries into here, so
+        // they're compiled inline with the stage that uses them
+        std::string Text = InlineLinkedLibraries(&Job->Source);
+        auto Start = std::chrono::steady_clock::now();
+        u32 ShaderID = CompileShader(Text, Job->Type, Job->Path, &Job->Source.Files, &Result->Log);
+        // NOTE(Jovan): Drivers are free to defer the actual work until the
+        // status is queried, CompileShader already did so the timing holds
+        Result->Milliseconds = MillisecondsSince(Start);
+        Result->Success = ShaderID != 0;
+        if(ShaderID) {
+            glDeleteShader(ShaderID);
+        }
+    }
+
+    MakeHeadlessContextCurrent(device, 0);
+}
+
+internal i32
+CompileOnly(const std::string &dir, u32 threadCount) {
+    std::vector<std::string> Paths;
+    if(!ListFiles(dir, Paths)) {
+        std::cerr << "[Err] Batch: Failed listing " << dir << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    Paths.erase(std::remove_if(Paths.begin(), Paths.end(), [](const std::string &Path) {
+        return !ShaderTypeFromPath(Path);
+    }), Paths.end());
+    std::sort(Paths.begin(), Paths.end());
+
+    auto Start = std::chrono::steady_clock::now();
+    shader_preprocessor Preprocessor;
+    Preprocessor.IncludeDirs.push_back(dir + "/include");
+    batch_compile Batch;
+    Batch.NextJob = 0;
+    CollectBatchJobs(&Batch, &Preprocessor, Paths);
+
+    egl_device Device;
+    if(!InitHeadlessDevice(&Device)) {
+        return 1;
+    }
+
+    if(!threadCount) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = std::max(1u, std::min(threadCount, (u32)Batch.Jobs.size()));
+
+    std::vector<egl_context> Contexts;
+    for(u32 ContextIndex = 0; ContextIndex < threadCount; ++ContextIndex) {
+        egl_context Context;
+        if(!CreateHeadlessContext(&Device, &Context)) {
+            break;
+        }
+        Contexts.push_back(Context);
+    }
+
+    // NOTE(Jovan): Function pointers are the same for every context of the
+    // display, loading them once before the workers start is enough
+    if(Contexts.empty() || !MakeHeadlessContextCurrent(&Device, &Contexts[0]) ||
+       !gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cerr << "[Err] Batch: Failed setting up a headless context" << std::endl;
+        for(egl_context &Context : Contexts) DestroyHeadlessContext(&Device, &Context);
+        ShutdownHeadlessDevice(&Device);
+        return 1;
+    }
+    MakeHeadlessContextCurrent(&Device, 0);
+
+    std::vector<std::thread> Workers;
+    for(egl_context &Context : Contexts) {
+        Workers.push_back(std::thread(_BatchWorker, &Batch, &Device, &Context));
+    }
+    for(std::thread &Worker : Workers) {
+        Worker.join();
+    }
+
+    u32 Failed = 0;
+    for(size_t JobIndex = 0; JobIndex < Batch.Jobs.size(); ++JobIndex) {
+        const batch_job &Job = Batch.Jobs[JobIndex];
+        const batch_result &Result = Batch.Results[JobIndex];
+        Failed += !Result.Success;
+        std::cout << "{\"file\":\"" << JsonEscape(Job.Path) << "\""
+                  << ",\"stage\":\"" << ShaderTypeName(Job.Type) << "\""
+                  << ",\"variant\":\"" << JsonEscape(Job.Variant) << "\""
+                  << ",\"status\":\"" << (Result.Success ? "ok" : "error") << "\""
+                  << ",\"ms\":" << std::max(Result.Milliseconds, 0.0)
+                  << ",\"log\":\"" << JsonEscape(Result.Log) << "\"}" << std::endl;
+    }
+    std::cout << "{\"summary\":true,\"compiled\":" << Batch.Jobs.size()
+              << ",\"failed\":" << Failed << ",\"threads\":" << Contexts.size()
+              << ",\"ms\":" << MillisecondsSince(Start) << "}" << std::endl;
+
+    for(egl_context &Context : Contexts) {
+        DestroyHeadlessContext(&Device, &Context);
+    }
+    ShutdownHeadlessDevice(&Device);
+    return Failed ? 1 : 0;
+}
+
+// NOTE(Jovan): Axes that decide what gets compiled in at all can't become
+// specialization constants, those stages stay on the text path
+internal b32
+AxisUsedInDirectives(const std::string &text, const variant_axis *axis) {
+    const char *At = text.c_str();
+    const char *End = At + text.size();
+    while(At < End) {
+        const char *LineEnd = (const char*)memchr(At, '\n', End - At);
+        if(!LineEnd) LineEnd = End;
+
+        const char *Cursor = SkipSpaces(At, LineEnd);
+        if(Cursor < LineEnd && *Cursor == '#') {
+            Cursor = SkipSpaces(Cursor + 1, LineEnd);
+            if(MatchWord(Cursor, LineEnd, "if") || MatchWord(Cursor, LineEnd, "elif") ||
+               MatchWord(Cursor, LineEnd, "ifdef") || MatchWord(Cursor, LineEnd, "ifndef")) {
+                while(Cursor < LineEnd) {
+                    const char *Word = Cursor;
+                    while(Cursor < LineEnd && (isalnum((u8)*Cursor) || *Cursor == '_')) ++Cursor;
+                    std::string Name(Word, Cursor);
+                    if(Name == axis->Name || Name.compare(0, axis->Name.size() + 1, axis->Name + "_") == 0) {
+                        return true;
+                    }
+                    if(Cursor == Word) ++Cursor;
+                }
+            }
+        }
+        At = LineEnd + 1;
+    }
+    return false;
+}
+
+// NOTE(Jovan): --spirv-source mode. Prints a stage the way the offline SPIR-V
+// step (spirv.sh) feeds it to glslang: includes resolved and every variant
+// axis declared as a specialization constant instead of a define
+internal i32
+PrintSpirvSource(const std::string &path, const std::vector<std::string> &includeDirs) {
+    shader_preprocessor Preprocessor;
+    Preprocessor.IncludeDirs = includeDirs;
+    preprocessed_source Source;
+    if(!PreprocessShader(&Preprocessor, NormalizePath(path), &Source)) {
+        return 1;
+    }
+
+    std::string Constants;
+    for(u32 AxisIndex = 0; AxisIndex < Source.Variants.size(); ++AxisIndex) {
+        const variant_axis *Axis = &Source.Variants[AxisIndex];
+        if(AxisUsedInDirectives(Source.Text, Axis)) {
+            std::cerr << "[Err] SPIR-V: " << path << " uses " << Axis->Name
+                      << " in the preprocessor, it can't be a specialization constant" << std::endl;
+            return 1;
+        }
+
+        b32 Numeric = true, Float = false;
+        for(const std::string &Value : Axis->Values) {
+            Numeric &= IsNumber(Value);
+            Float |= Value.find_first_of(".eE") != std::string::npos;
+        }
+        Constants += "layout(constant_id = " + std::to_string(AxisIndex) + ") const " +
+                     (Numeric && Float ? "float " : "int ") + Axis->Name + " = " +
+                     (Numeric ? Axis->Values[0] : "0") + ";\n";
+        if(!Numeric) {
+            for(u32 ValueIndex = 0; ValueIndex < Axis->Values.size(); ++ValueIndex) {
+                Constants += "const int " + Axis->Name + "_" + Axis->Values[ValueIndex] + " = " +
+                             std::to_string(ValueIndex) + ";\n";
+            }
+        }
+    }
+
+    // NOTE(Jovan): A module can't link against anything, the libraries get
+    // compiled straight into it
+    preprocessed_source Injected = InjectVariantDefines(Source, Constants);
+    std::cout << InlineLinkedLibraries(&Injected);
+    return 0;
+}
@@ -0,0 +1,225 @@
+// NOTE(Jovan): Reload benchmark. Every new program that shows up on screen
+// gets its draw timed with GL_TIME_ELAPSED queries for a fixed number of
+// frames once it's warm. The result is compared against the previous
+// version of the same variant (Welch's t, since the spreads rarely match),
+// printed and appended to a local log
+
+#define BENCH_WARMUP_FRAMES 30
+#define BENCH_SAMPLE_FRAMES 120
+#define BENCH_QUERY_COUNT 4
+#define BENCH_LOG_PATH "frag_bench.log"
+
+struct bench_baseline {
+    u32 Build;
+    i32 Width;
+    i32 Height;
+    std::vector<r64> Samples;
+};
+
+struct bench_state {
+    b32 Enabled;
+    u32 Queries[BENCH_QUERY_COUNT];
+    u32 QueryRun[BENCH_QUERY_COUNT];
+    b32 QueryPending[BENCH_QUERY_COUNT];
+    u32 NextQuery;
+    b32 Timing;
+
+    u32 Run;
+    u32 Build;
+    u32 Key;
+    i32 Width;
+    i32 Height;
+    u32 Warmup;
+    b32 Finished;
+    std::vector<r64> Samples;
+    std::unordered_map<u32, bench_baseline> Baselines;
+};
+
+internal void
+InitBench(bench_state *bench) {
+    glGenQueries(BENCH_QUERY_COUNT, bench->Queries);
+}
+
+internal void
+MeanAndVariance(const std::vector<r64> &samples, r64 *mean, r64 *variance) {
+    r64 Sum = 0.0;
+    for(r64 Sample : samples) Sum += Sample;
+    *mean = Sum / samples.size();
+
+    r64 Squares = 0.0;
+    for(r64 Sample : samples) Squares += (Sample - *mean) * (Sample - *mean);
+    *variance = samples.size() > 1 ? Squares / (samples.size() - 1) : 0.0;
+}
+
+// NOTE(Jovan): Two sided 97.5% quantile of Student's t, the Cornish-Fisher
+// expansion is well within what frame timings can tell apart
+internal r64
+StudentT975(r64 degrees) {
+    r64 Z = 1.959964;
+    r64 Z3 = Z * Z * Z, Z5 = Z3 * Z * Z;
+    return Z + (Z3 + Z) / (4.0 * degrees) + (5.0 * Z5 + 16.0 * Z3 + 3.0 * Z) / (96.0 * degrees * degrees);
+}
+
+internal std::string
+BenchTimestamp() {
+    char Buffer[32];
+    time_t Now = time(0);
+    strftime(Buffer, sizeof(Buffer), "%Y-%m-%dT%H:%M:%S", localtime(&Now));
+    return Buffer;
+}
+
+internal void
+FinishBench(bench_state *bench, const variant_set *set) {
+    r64 Mean, Variance;
+    MeanAndVariance(bench->Samples, &Mean, &Variance);
+    std::string Variant = set->Axes.empty() ? "" : VariantKeyName(set, bench->Key);
+    std::string Name = set->Base.FragmentPath + (Variant.empty() ? "" : " [" + Variant + "]");
+
+    std::string Json = "{\"time\":\"" + BenchTimestamp() + "\",\"file\":\"" + JsonEscape(set->Base.FragmentPath) +
+                       "\",\"variant\":\"" + JsonEscape(Variant) + "\",\"width\":" + std::to_string(bench->Width) +
+                       ",\"height\":" + std::to_string(bench->Height) +
+                       ",\"frames\":" + std::to_string(bench->Samples.size()) +
+                       ",\"mean_ms\":" + std::to_string(Mean) + ",\"stddev_ms\":" + std::to_string(sqrt(Variance));
+
+    // NOTE(Jovan): Only versions drawn at the same size are comparable
+    auto Baseline = bench->Baselines.find(bench->Key);
+    if(Baseline != bench->Baselines.end() && Baseline->second.Build != bench->Build &&
+       Baseline->second.Width == bench->Width && Baseline->second.Height == bench->Height) {
+        r64 PreviousMean, PreviousVariance;
+        MeanAndVariance(Baseline->second.Samples, &PreviousMean, &PreviousVariance);
+        r64 A = Variance / bench->Samples.size();
+        r64 B = PreviousVariance / Baseline->second.Samples.size();
+        r64 Error = sqrt(A + B);
+        r64 Degrees = (A + B) * (A + B) /
+                      std::max(A * A / (bench->Samples.size() - 1) + B * B / (Baseline->second.Samples.size() - 1), 1e-30);
+        r64 Margin = StudentT975(std::max(Degrees, 1.0)) * Error;
+
+        r64 Change = 100.0 * (Mean - PreviousMean) / PreviousMean;
+        r64 ChangeMargin = 100.0 * Margin / PreviousMean;
+        const char *Verdict = Mean - Margin > PreviousMean ? "slower" :
+                              Mean + Margin < PreviousMean ? "faster" : "no significant change";
+
+        char Line[256];
+        snprintf(Line, sizeof(Line), "%.3f ms -> %.3f ms, %+.1f%% +-%.1f%% (95%% CI), %s",
+                 PreviousMean, Mean, Change, ChangeMargin, Verdict);
+        if(Mean - Margin > PreviousMean) {
+            std::cerr << "[Err] Bench: " << Name << ": " << Line << std::endl;
+        } else {
+            std::cout << "[Info] Bench: " << Name << ": " << Line << std::endl;
+        }
+
+        Json += ",\"previous_ms\":" + std::to_string(PreviousMean) + ",\"change_pct\":" + std::to_string(Change) +
+                ",\"ci_low_pct\":" + std::to_string(Change - ChangeMargin) +
+                ",\"ci_high_pct\":" + std::to_string(Change + ChangeMargin) + ",\"verdict\":\"" + Verdict + "\"";
+    } else {
+        char Line[128];
+        snprintf(Line, sizeof(Line), "%.3f ms +-%.3f ms over %zu frames at %dx%d", Mean, sqrt(Variance),
+                 bench->Samples.size(), bench->Width, bench->Height);
+        std::cout << "[Info] Bench: " << Name << ": " << Line << std::endl;
+    }
+
+    std::ofstream Log(BENCH_LOG_PATH, std::ios::app);
+    if(Log) {
+        Log << Json << "}" << std::endl;
+    } else {
+        std::cerr << "[Err] Bench: Failed writing " << BENCH_LOG_PATH << std::endl;
+    }
+
+    bench_baseline &Entry = bench->Baselines[bench->Key];
+    Entry.Build = bench->Build;
+    Entry.Width = bench->Width;
+    Entry.Height = bench->Height;
+    Entry.Samples = bench->Samples;
+    bench->Finished = true;
+}
+
+// NOTE(Jovan): Results come back a few frames late, the queries are never
+// waited on. Anything from a run that got restarted is thrown away
+internal void
+CollectBenchQueries(bench_state *bench) {
+    for(u32 QueryIndex = 0; QueryIndex < BENCH_QUERY_COUNT; ++QueryIndex) {
+        if(!bench->QueryPending[QueryIndex]) {
+            continue;
+        }
+        i32 Available = 0;
+        glGetQueryObjectiv(bench->Queries[QueryIndex], GL_QUERY_RESULT_AVAILABLE, &Available);
+        if(!Available) {
+            continue;
+        }
+
+        GLuint64 Nanoseconds = 0;
+        glGetQueryObjectui64v(bench->Queries[QueryIndex], GL_QUERY_RESULT, &Nanoseconds);
+        bench->QueryPending[QueryIndex] = false;
+        if(bench->QueryRun[QueryIndex] == bench->Run && !bench->Finished &&
+           bench->Samples.size() < BENCH_SAMPLE_FRAMES) {
+            bench->Samples.push_back(Nanoseconds / 1e6);
+        }
+    }
+}
+
+// NOTE(Jovan): Call right before the draw, a new build, variant or window
+// size starts a new run. No program, or one that isn't built, pauses timing
+internal void
+BeginBenchFrame(bench_state *bench, const shader_program *program, u32 key, i32 width, i32 height) {
+    bench->Timing = false;
+    if(!bench->Enabled || !program || !program->ID) {
+        return;
+    }
+
+    if(program->Build != bench->Build || key != bench->Key || width != bench->Width || height != bench->Height) {
+        ++bench->Run;
+        bench->Build = program->Build;
+        bench->Key = key;
+        bench->Width = width;
+        bench->Height = height;
+        bench->Warmup = 0;
+        bench->Samples.clear();
+
+        // NOTE(Jovan): Flipping back to a variant that was already measured
+        // doesn't need another run
+        auto Baseline = bench->Baselines.find(key);
+        bench->Finished = Baseline != bench->Baselines.end() && Baseline->second.Build == program->Build &&
+                          Baseline->second.Width == width && Baseline->second.Height == height;
+    }
+    if(bench->Finished || bench->Warmup++ < BENCH_WARMUP_FRAMES) {
+        return;
+    }
+
+    u32 QueryIndex = bench->NextQuery;
+    if(bench->QueryPending[QueryIndex]) {
+        return;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, bench->Queries[QueryIndex]);
+    bench->QueryRun[QueryIndex] = bench->Run;
+    bench->Timing = true;
+}
+
+internal void
+EndBenchFrame(bench_state *bench, const variant_set *set) {
+    if(bench->Timing) {
+        glEndQuery(GL_TIME_ELAPSED);
+        bench->QueryPending[bench->NextQuery] = true;
+        bench->NextQuery = (bench->NextQuery + 1) % BENCH_QUERY_COUNT;
+        bench->Timing = false;
+    }
+    if(!bench->Enabled) {
+        return;
+    }
+
+    CollectBenchQueries(bench);
+    if(!bench->Finished && bench->Samples.size() >= BENCH_SAMPLE_FRAMES) {
+        FinishBench(bench, set);
+    }
+}
+
+// NOTE(Jovan): For the idle check, a run needs frames to keep coming until
+// it has all its samples
+internal b32
+BenchRunning(const bench_state *bench) {
+    return bench->Enabled && bench->Build && !bench->Finished;
+}
+
+internal void
+ShutdownBench(bench_state *bench) {
+    glDeleteQueries(BENCH_QUERY_COUNT, bench->Queries);
+}
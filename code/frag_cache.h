@@ -0,0 +1,222 @@
+// NOTE(Jovan): On-disk cache of linked program binaries. Entries are keyed by
+// a hash of the program sources and the driver strings so a driver update
+// or a source edit simply misses and falls back to compiling
+
+#define PROGRAM_CACHE_MAGIC 0x48434746
+#define PROGRAM_CACHE_VERSION 1
+
+struct program_cache_header {
+    u32 Magic;
+    u32 Version;
+    u64 Key;
+    u32 Format;
+    u32 Length;
+};
+
+struct program_cache {
+    b32 Enabled;
+    std::string Dir;
+    u64 DriverHash;
+    std::atomic<u32> Hits;
+    std::atomic<u32> Misses;
+    std::atomic<u32> Stale;
+};
+
+global program_cache G_PROGRAM_CACHE;
+
+// NOTE(Jovan): MurmurHash64A, eats 8 bytes per step which matters once the
+// sources get into the hundreds of kilobytes
+internal u64
+Hash64(const void *data, size_t length, u64 seed) {
+    const u64 M = 0xc6a4a7935bd1e995ULL;
+    const i32 R = 47;
+    u64 H = seed ^ (length * M);
+
+    const u8 *At = (const u8*)data;
+    const u8 *End = At + (length & ~(size_t)7);
+    for(; At != End; At += 8) {
+        u64 K;
+        memcpy(&K, At, sizeof(K));
+        K *= M;
+        K ^= K >> R;
+        K *= M;
+        H ^= K;
+        H *= M;
+    }
+
+    switch(length & 7) {
+        case 7: H ^= (u64)At[6] << 48;
+        case 6: H ^= (u64)At[5] << 40;
+        case 5: H ^= (u64)At[4] << 32;
+        case 4: H ^= (u64)At[3] << 24;
+        case 3: H ^= (u64)At[2] << 16;
+        case 2: H ^= (u64)At[1] << 8;
+        case 1: H ^= (u64)At[0];
+                H *= M;
+    }
+
+    H ^= H >> R;
+    H *= M;
+    H ^= H >> R;
+    return H;
+}
+
+internal u64
+HashString(const std::string &str, u64 seed) {
+    return Hash64(str.data(), str.size(), seed);
+}
+
+internal std::string
+DefaultProgramCacheDir() {
+    const char *XDGCache = getenv("XDG_CACHE_HOME");
+    if(XDGCache && *XDGCache) {
+        return std::string(XDGCache) + "/frag/programs";
+    }
+    const char *Home = getenv("HOME");
+    if(Home && *Home) {
+        return std::string(Home) + "/.cache/frag/programs";
+    }
+    return ".frag_cache";
+}
+
+// NOTE(Jovan): Needs a current context, the driver strings are part of the key
+internal b32
+InitProgramCache(program_cache *cache, const std::string &dir) {
+    cache->Enabled = false;
+    cache->Hits = 0;
+    cache->Misses = 0;
+    cache->Stale = 0;
+
+    if(!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary) {
+        std::cout << "[Info] Cache: Program binaries not supported, cache disabled" << std::endl;
+        return false;
+    }
+
+    i32 FormatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &FormatCount);
+    if(FormatCount <= 0) {
+        std::cout << "[Info] Cache: Driver exposes no program binary formats, cache disabled" << std::endl;
+        return false;
+    }
+
+    if(!MakeDirectories(dir)) {
+        std::cerr << "[Err] Cache: Failed creating " << dir << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    const char *Renderer = (const char*)glGetString(GL_RENDERER);
+    const char *Version = (const char*)glGetString(GL_VERSION);
+    std::string Driver = std::string(Renderer ? Renderer : "") + "\n" + (Version ? Version : "");
+
+    cache->Dir = dir;
+    cache->DriverHash = HashString(Driver, PROGRAM_CACHE_VERSION);
+    cache->Enabled = true;
+    return true;
+}
+
+internal u64
+ProgramCacheKey(const program_cache *cache, const std::string *sources, u32 count) {
+    u64 Key = cache->DriverHash;
+    for(u32 SourceIndex = 0; SourceIndex < count; ++SourceIndex) {
+        Key = HashString(sources[SourceIndex], Key);
+    }
+    return Key;
+}
+
+internal std::string
+ProgramCachePath(const program_cache *cache, u64 key) {
+    char Name[32];
+    snprintf(Name, sizeof(Name), "%016llx.bin", (unsigned long long)key);
+    return cache->Dir + "/" + Name;
+}
+
+internal u32
+LoadCachedProgram(program_cache *cache, u64 key) {
+    std::string Path = ProgramCachePath(cache, key);
+    std::string Data;
+    if(!ReadEntireFile(Path, Data)) {
+        ++cache->Misses;
+        return 0;
+    }
+
+    program_cache_header Header;
+    b32 Valid = Data.size() >= sizeof(Header);
+    if(Valid) {
+        memcpy(&Header, Data.data(), sizeof(Header));
+        Valid = Header.Magic == PROGRAM_CACHE_MAGIC &&
+                Header.Version == PROGRAM_CACHE_VERSION &&
+                Header.Key == key &&
+                Header.Length == Data.size() - sizeof(Header);
+    }
+
+    u32 ProgramID = 0;
+    if(Valid) {
+        ProgramID = glCreateProgram();
+        glProgramBinary(ProgramID, Header.Format, Data.data() + sizeof(Header), Header.Length);
+
+        // NOTE(Jovan): Drivers reject binaries from other builds here, which is
+        // the usual way an entry goes stale
+        i32 Success = 0;
+        glGetProgramiv(ProgramID, GL_LINK_STATUS, &Success);
+        if(!Success) {
+            glDeleteProgram(ProgramID);
+            ProgramID = 0;
+        }
+    }
+
+    if(!ProgramID) {
+        ++cache->Stale;
+        ++cache->Misses;
+        unlink(Path.c_str());
+        return 0;
+    }
+
+    ++cache->Hits;
+    return ProgramID;
+}
+
+internal void
+StoreCachedProgram(program_cache *cache, u64 key, u32 programID) {
+    i32 Length = 0;
+    glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &Length);
+    if(Length <= 0) {
+        return;
+    }
+
+    std::string Data(sizeof(program_cache_header) + Length, '\0');
+    GLenum Format = 0;
+    GLsizei Written = 0;
+    glGetProgramBinary(programID, Length, &Written, &Format, &Data[sizeof(program_cache_header)]);
+    if(Written <= 0) {
+        return;
+    }
+    Data.resize(sizeof(program_cache_header) + Written);
+
+    program_cache_header Header = {PROGRAM_CACHE_MAGIC, PROGRAM_CACHE_VERSION, key, Format, (u32)Written};
+    memcpy(&Data[0], &Header, sizeof(Header));
+
+    // NOTE(Jovan): Write next to the entry and rename over it so a concurrent
+    // reader never sees a half written binary
+    std::string Path = ProgramCachePath(cache, key);
+    std::string TempPath = Path + ".tmp." + std::to_string(getpid()) + "." +
+                           std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    std::ofstream Out(TempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    Out.write(Data.data(), Data.size());
+    Out.close();
+    if(!Out || rename(TempPath.c_str(), Path.c_str()) < 0) {
+        std::cerr << "[Err] Cache: Failed writing " << Path << std::endl;
+        unlink(TempPath.c_str());
+    }
+}
+
+internal void
+PrintProgramCacheStats(const program_cache *cache) {
+    if(!cache->Enabled) {
+        return;
+    }
+    std::cout << "[Info] Cache: " << cache->Hits << " hit(s), " << cache->Misses << " miss(es)";
+    if(cache->Stale) {
+        std::cout << ", " << cache->Stale << " stale";
+    }
+    std::cout << std::endl;
+}
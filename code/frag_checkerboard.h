@@ -0,0 +1,331 @@
+// NOTE(Jovan): Checkerboard rendering. A stencil mask of square blocks lets the
+// shader through on half of them, the other half the next frame, and a resolve
+// pass fills in the blocks that weren't shaded. Whole blocks because the GPU
+// shades pixels in groups, a per pixel pattern would still pay for every group
+// that's partly covered. That's 2x2 quads on GPUs, software rasterizers like
+// llvmpipe want 4x4. The holes come from the previous frame when that's safe:
+// as is if nothing the program reads changed, moved along "out vec2 Motion"
+// (pixels per second) if the shader writes one, clamped to what's around them
+// so misses don't smear. With neither they're interpolated from the neighbors
+// shaded this frame
+
+#define CHECKER_DEFAULT_BLOCK 2
+#define CHECKER_MAX_BLOCK 32
+
+global const char *CHECKER_MASK_FRAGMENT_SOURCE = R"(#version 330 core
+uniform int BlockShift;
+
+void main() {
+    ivec2 Block = ivec2(gl_FragCoord.xy) >> BlockShift;
+    if(((Block.x + Block.y) & 1) == 0) {
+        discard;
+    }
+}
+)";
+
+global const char *CHECKER_RESOLVE_FRAGMENT_SOURCE = R"(#version 330 core
+uniform sampler2D Current;
+uniform sampler2D Motion;
+uniform sampler2D History;
+uniform int BlockShift;
+uniform int Phase;
+uniform int HistoryMode;
+uniform float TimeDelta;
+out vec4 FragColor;
+
+ivec2 Size;
+
+bool Inside(ivec2 P) {
+    return all(greaterThanEqual(P, ivec2(0))) && all(lessThan(P, Size));
+}
+
+// NOTE(Jovan): Linear between the shaded pixels on either side of the block
+vec4 Between(ivec2 A, ivec2 B, int DistanceA, int DistanceB) {
+    if(!Inside(A)) return texelFetch(Current, B, 0);
+    if(!Inside(B)) return texelFetch(Current, A, 0);
+    return (texelFetch(Current, A, 0) * float(DistanceB) + texelFetch(Current, B, 0) * float(DistanceA)) /
+           float(DistanceA + DistanceB);
+}
+
+void main() {
+    ivec2 P = ivec2(gl_FragCoord.xy);
+    Size = textureSize(Current, 0);
+    vec4 Color = texelFetch(Current, P, 0);
+    if((((P.x >> BlockShift) + (P.y >> BlockShift)) & 1) == Phase) {
+        FragColor = Color;
+        return;
+    }
+
+    ivec2 Before = (P & ((1 << BlockShift) - 1)) + 1;
+    ivec2 After = (1 << BlockShift) + 1 - Before;
+    ivec2 Left = P - ivec2(Before.x, 0), Right = P + ivec2(After.x, 0);
+    ivec2 Down = P - ivec2(0, Before.y), Up = P + ivec2(0, After.y);
+    vec4 Spatial = 0.5 * (Between(Left, Right, Before.x, After.x) + Between(Down, Up, Before.y, After.y));
+    if(HistoryMode == 0) {
+        FragColor = Spatial;
+        return;
+    }
+    if(HistoryMode == 1) {
+        FragColor = texelFetch(History, P, 0);
+        return;
+    }
+
+    ivec2 H = Inside(Left) && (Before.x <= After.x || !Inside(Right)) ? Left : Right;
+    ivec2 V = Inside(Down) && (Before.y <= After.y || !Inside(Up)) ? Down : Up;
+    vec2 Velocity = 0.5 * (texelFetch(Motion, H, 0).xy + texelFetch(Motion, V, 0).xy);
+    vec2 Previous = gl_FragCoord.xy - Velocity * TimeDelta;
+    if(any(lessThan(Previous, vec2(0.0))) || any(greaterThan(Previous, vec2(Size)))) {
+        FragColor = Spatial;
+        return;
+    }
+
+    vec4 Low = vec4(1e30), High = vec4(-1e30);
+    for(int Tap = 0; Tap < 4; ++Tap) {
+        ivec2 Q = Tap == 0 ? Left : Tap == 1 ? Right : Tap == 2 ? Down : Up;
+        if(Inside(Q)) {
+            vec4 Neighbour = texelFetch(Current, Q, 0);
+            Low = min(Low, Neighbour);
+            High = max(High, Neighbour);
+        }
+    }
+    FragColor = clamp(texture(History, Previous / vec2(Size)), Low, High);
+}
+)";
+
+enum checker_history {
+    CheckerHistory_None,
+    CheckerHistory_Static,
+    CheckerHistory_Reprojected,
+};
+
+struct checkerboard_renderer {
+    b32 Enabled;
+    u32 BlockSize;
+
+    u32 MaskProgram;
+    u32 ResolveProgram;
+    i32 PhaseLocation;
+    i32 HistoryModeLocation;
+    i32 TimeDeltaLocation;
+    u32 Framebuffer;
+    u32 ColorTexture;
+    u32 MotionTexture;
+    u32 DepthStencil;
+    u32 HistoryFramebuffers[2];
+    u32 HistoryTextures[2];
+    u32 Current;
+    u32 BlockShift;
+    i32 Width;
+    i32 Height;
+
+    u32 ProgramID;
+    i32 MotionLocation;
+    b32 MaskStale;
+    b32 HistoryValid;
+    checker_history History;
+    u32 Phase;
+    r32 PreviousTime;
+    r32 TimeDelta;
+};
+
+internal void
+InitCheckerboard(checkerboard_renderer *checker) {
+    checker->MaskProgram = BuildFullscreenProgram(CHECKER_MASK_FRAGMENT_SOURCE, "checker mask");
+    checker->ResolveProgram = BuildFullscreenProgram(CHECKER_RESOLVE_FRAGMENT_SOURCE, "checker resolve");
+    glGenFramebuffers(1, &checker->Framebuffer);
+    glGenTextures(1, &checker->ColorTexture);
+    glGenTextures(1, &checker->MotionTexture);
+    glGenRenderbuffers(1, &checker->DepthStencil);
+    glGenFramebuffers(2, checker->HistoryFramebuffers);
+    glGenTextures(2, checker->HistoryTextures);
+    checker->MotionLocation = -1;
+
+    u32 BlockSize = std::max(1u, std::min(checker->BlockSize, (u32)CHECKER_MAX_BLOCK));
+    while((2u << checker->BlockShift) <= BlockSize) {
+        ++checker->BlockShift;
+    }
+    if(checker->BlockSize != (1u << checker->BlockShift)) {
+        checker->BlockSize = 1u << checker->BlockShift;
+        std::cerr << "[Err] Checkerboard: Blocks have to be a power of two up to " << CHECKER_MAX_BLOCK
+                  << ", using " << checker->BlockSize << std::endl;
+    }
+
+    // NOTE(Jovan): Block size and texture units are fixed, only the phase and
+    // what the holes come from change per frame
+    if(checker->MaskProgram) {
+        glUseProgram(checker->MaskProgram);
+        glUniform1i(glGetUniformLocation(checker->MaskProgram, "BlockShift"), (i32)checker->BlockShift);
+    }
+    if(checker->ResolveProgram) {
+        glUseProgram(checker->ResolveProgram);
+        glUniform1i(glGetUniformLocation(checker->ResolveProgram, "Current"), 0);
+        glUniform1i(glGetUniformLocation(checker->ResolveProgram, "Motion"), 1);
+        glUniform1i(glGetUniformLocation(checker->ResolveProgram, "History"), 2);
+        glUniform1i(glGetUniformLocation(checker->ResolveProgram, "BlockShift"), (i32)checker->BlockShift);
+        checker->PhaseLocation = glGetUniformLocation(checker->ResolveProgram, "Phase");
+        checker->HistoryModeLocation = glGetUniformLocation(checker->ResolveProgram, "HistoryMode");
+        checker->TimeDeltaLocation = glGetUniformLocation(checker->ResolveProgram, "TimeDelta");
+    }
+}
+
+internal void
+AllocateCheckerTexture(u32 texture, GLenum format, GLenum filter, i32 width, i32 height) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format == GL_RG16F ? GL_RG : GL_RGBA,
+                 format == GL_RG16F ? GL_FLOAT : GL_UNSIGNED_BYTE, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+internal void
+ResizeCheckerboard(checkerboard_renderer *checker, i32 width, i32 height) {
+    checker->Width = width;
+    checker->Height = height;
+    AllocateCheckerTexture(checker->ColorTexture, GL_RGBA8, GL_NEAREST, width, height);
+    AllocateCheckerTexture(checker->MotionTexture, GL_RG16F, GL_NEAREST, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, checker->DepthStencil);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, checker->Framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, checker->ColorTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, checker->MotionTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, checker->DepthStencil);
+    for(u32 Index = 0; Index < 2; ++Index) {
+        AllocateCheckerTexture(checker->HistoryTextures[Index], GL_RGBA8, GL_LINEAR, width, height);
+        glBindFramebuffer(GL_FRAMEBUFFER, checker->HistoryFramebuffers[Index]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, checker->HistoryTextures[Index], 0);
+    }
+
+    checker->MaskStale = true;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// NOTE(Jovan): Call with the program bound and its uniforms reflected but not
+// uploaded yet, that's the only time it can tell what changed. Picks what
+// this frame's holes get filled from
+internal void
+BeginCheckerboardFrame(checkerboard_renderer *checker, u32 programID, const uniform_table *table,
+                       r32 time, i32 width, i32 height) {
+    if(checker->Width != width || checker->Height != height) {
+        ResizeCheckerboard(checker, width, height);
+        checker->HistoryValid = false;
+    }
+    if(checker->ProgramID != programID) {
+        checker->ProgramID = programID;
+        checker->MotionLocation = glGetFragDataLocation(programID, "Motion");
+        checker->HistoryValid = false;
+
+        GLenum DrawBuffers[2] = {GL_COLOR_ATTACHMENT0, GL_NONE};
+        if(checker->MotionLocation == 0 || checker->MotionLocation == 1) {
+            DrawBuffers[checker->MotionLocation] = GL_COLOR_ATTACHMENT1;
+            DrawBuffers[checker->MotionLocation ^ 1] = GL_COLOR_ATTACHMENT0;
+        } else {
+            checker->MotionLocation = -1;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, checker->Framebuffer);
+        glDrawBuffers(2, DrawBuffers);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    b32 Changed = false;
+    for(u32 Handle = 0; Handle < table->Slots.size(); ++Handle) {
+        const uniform_slot *Slot = &table->Slots[Handle];
+        if(Slot->Location >= 0 && Slot->Dirty) {
+            Changed = true;
+            break;
+        }
+    }
+
+    checker->History = CheckerHistory_None;
+    if(checker->HistoryValid) {
+        if(!Changed) {
+            checker->History = CheckerHistory_Static;
+        } else if(checker->MotionLocation >= 0) {
+            checker->History = CheckerHistory_Reprojected;
+        }
+    }
+    checker->TimeDelta = time - checker->PreviousTime;
+    checker->PreviousTime = time;
+    checker->Phase ^= 1;
+}
+
+// NOTE(Jovan): The mask is drawn once per size into the stencil, blocks of
+// one color get 1 and the rest stay 0
+internal void
+DrawCheckerMask(checkerboard_renderer *checker, u32 vao) {
+    glClearStencil(0);
+    glClear(GL_STENCIL_BUFFER_BIT);
+    glStencilFunc(GL_ALWAYS, 1, 1);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glUseProgram(checker->MaskProgram);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    glUseProgram(checker->ProgramID);
+    checker->MaskStale = false;
+}
+
+// NOTE(Jovan): Binds the target and lets only this frame's blocks through.
+// Depth gets cleared, color doesn't need to be since the holes are never read
+internal void
+BeginCheckerboardDraw(checkerboard_renderer *checker, u32 vao) {
+    glBindFramebuffer(GL_FRAMEBUFFER, checker->Framebuffer);
+    glViewport(0, 0, checker->Width, checker->Height);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_STENCIL_TEST);
+    if(checker->MaskStale && checker->MaskProgram) {
+        DrawCheckerMask(checker, vao);
+    }
+    glStencilFunc(GL_EQUAL, checker->Phase, 1);
+}
+
+// NOTE(Jovan): Resolves into the next history target and shows that
+internal void
+EndCheckerboardDraw(checkerboard_renderer *checker, u32 vao) {
+    glDisable(GL_STENCIL_TEST);
+    if(!checker->ResolveProgram) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return;
+    }
+
+    u32 Previous = checker->Current;
+    checker->Current ^= 1;
+    glBindFramebuffer(GL_FRAMEBUFFER, checker->HistoryFramebuffers[checker->Current]);
+    glUseProgram(checker->ResolveProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, checker->ColorTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, checker->MotionTexture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, checker->HistoryTextures[Previous]);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(checker->PhaseLocation, (i32)checker->Phase);
+    glUniform1i(checker->HistoryModeLocation, (i32)checker->History);
+    glUniform1f(checker->TimeDeltaLocation, checker->TimeDelta);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    checker->HistoryValid = true;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, checker->HistoryFramebuffers[checker->Current]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, checker->Width, checker->Height, 0, 0, checker->Width, checker->Height,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+internal void
+ShutdownCheckerboard(checkerboard_renderer *checker) {
+    if(checker->MaskProgram) glDeleteProgram(checker->MaskProgram);
+    if(checker->ResolveProgram) glDeleteProgram(checker->ResolveProgram);
+    glDeleteFramebuffers(1, &checker->Framebuffer);
+    glDeleteTextures(1, &checker->ColorTexture);
+    glDeleteTextures(1, &checker->MotionTexture);
+    glDeleteRenderbuffers(1, &checker->DepthStencil);
+    glDeleteFramebuffers(2, checker->HistoryFramebuffers);
+    glDeleteTextures(2, checker->HistoryTextures);
+}
@@ -0,0 +1,678 @@
+// NOTE(Jovan): Static per-pixel cost estimate. Works on the preprocessed text
+// with a small conditional evaluator so every variant is costed on its own.
+// There's no real parser behind this, just tokens, brace matching and a
+// table of builtins, good enough to rank shaders and catch the usual traps
+
+#define COST_UNKNOWN_TRIPS 64
+#define COST_TEXTURE_WEIGHT 8
+#define COST_TRANSCENDENTAL_WEIGHT 4
+
+enum cost_category {
+    Cost_None,
+    Cost_ALU,
+    Cost_Texture,
+    Cost_Transcendental,
+};
+
+struct cost_builtin {
+    const char *Name;
+    cost_category Category;
+    u32 Ops;
+};
+
+// NOTE(Jovan): Ops are rough scalar instruction counts, not cycles
+global cost_builtin G_COST_BUILTINS[] = {
+    {"texture", Cost_Texture, 1}, {"textureLod", Cost_Texture, 1}, {"textureGrad", Cost_Texture, 1},
+    {"textureOffset", Cost_Texture, 1}, {"textureProj", Cost_Texture, 1}, {"texelFetch", Cost_Texture, 1},
+    {"textureGather", Cost_Texture, 1}, {"texture2D", Cost_Texture, 1}, {"textureCube", Cost_Texture, 1},
+    {"sin", Cost_Transcendental, 1}, {"cos", Cost_Transcendental, 1}, {"tan", Cost_Transcendental, 2},
+    {"asin", Cost_Transcendental, 2}, {"acos", Cost_Transcendental, 2}, {"atan", Cost_Transcendental, 2},
+    {"exp", Cost_Transcendental, 1}, {"exp2", Cost_Transcendental, 1}, {"log", Cost_Transcendental, 1},
+    {"log2", Cost_Transcendental, 1}, {"pow", Cost_Transcendental, 2}, {"sqrt", Cost_Transcendental, 1},
+    {"inversesqrt", Cost_Transcendental, 1},
+    {"abs", Cost_ALU, 1}, {"sign", Cost_ALU, 1}, {"floor", Cost_ALU, 1}, {"ceil", Cost_ALU, 1},
+    {"fract", Cost_ALU, 1}, {"mod", Cost_ALU, 2}, {"min", Cost_ALU, 1}, {"max", Cost_ALU, 1},
+    {"clamp", Cost_ALU, 2}, {"mix", Cost_ALU, 2}, {"step", Cost_ALU, 1}, {"smoothstep", Cost_ALU, 4},
+    {"dot", Cost_ALU, 3}, {"cross", Cost_ALU, 6}, {"length", Cost_ALU, 4}, {"distance", Cost_ALU, 5},
+    {"normalize", Cost_ALU, 5}, {"reflect", Cost_ALU, 5}, {"refract", Cost_ALU, 8},
+    {"dFdx", Cost_ALU, 1}, {"dFdy", Cost_ALU, 1}, {"fwidth", Cost_ALU, 2},
+};
+
+global const char *G_COST_KEYWORDS[] = {
+    "if", "else", "for", "while", "do", "return", "switch", "case", "break", "continue", "discard",
+    "float", "int", "uint", "bool", "vec2", "vec3", "vec4", "ivec2", "ivec3", "ivec4", "uvec2", "uvec3",
+    "uvec4", "bvec2", "bvec3", "bvec4", "mat2", "mat3", "mat4", "void", "struct", "layout",
+};
+
+enum cost_token_kind {
+    CostToken_Identifier,
+    CostToken_Number,
+    CostToken_Symbol,
+};
+
+struct cost_token {
+    cost_token_kind Kind;
+    std::string Text;
+    u32 File;
+    u32 Line;
+};
+
+struct cost_counts {
+    r64 ALU;
+    r64 Texture;
+    r64 Transcendental;
+};
+
+struct cost_call {
+    std::string Name;
+    r64 Count;
+    b32 InLoop;
+    u32 File;
+    u32 Line;
+};
+
+struct cost_flag {
+    std::string Kind;
+    std::string Function;
+    u32 File;
+    u32 Line;
+};
+
+struct cost_function {
+    std::string Name;
+    cost_counts Self;
+    cost_counts Total;
+    u32 Loops;
+    std::vector<cost_call> Calls;
+    b32 Resolved;
+};
+
+struct cost_report {
+    std::vector<cost_function> Functions;
+    std::vector<cost_flag> Flags;
+    std::unordered_map<std::string, r64> Constants;
+};
+
+internal r64
+CostScore(const cost_counts &counts) {
+    return counts.ALU + COST_TEXTURE_WEIGHT * counts.Texture + COST_TRANSCENDENTAL_WEIGHT * counts.Transcendental;
+}
+
+internal b32
+IsIdentifierChar(char c) {
+    return isalnum((u8)c) || c == '_';
+}
+
+// NOTE(Jovan): Tiny #if evaluator, numbers, defined() and the C operators
+// that actually show up in shader conditionals
+struct cost_condition {
+    std::vector<std::string> Tokens;
+    size_t At;
+    const std::unordered_map<std::string, std::string> *Defines;
+};
+
+internal r64 EvaluateCondition(cost_condition *cond, i32 precedence);
+
+internal r64
+EvaluateConditionPrimary(cost_condition *cond) {
+    if(cond->At >= cond->Tokens.size()) {
+        return 0;
+    }
+
+    std::string Token = cond->Tokens[cond->At++];
+    if(Token == "(") {
+        r64 Value = EvaluateCondition(cond, 0);
+        if(cond->At < cond->Tokens.size() && cond->Tokens[cond->At] == ")") ++cond->At;
+        return Value;
+    }
+    if(Token == "!") return !EvaluateConditionPrimary(cond);
+    if(Token == "-") return -EvaluateConditionPrimary(cond);
+    if(Token == "defined") {
+        b32 Paren = cond->At < cond->Tokens.size() && cond->Tokens[cond->At] == "(";
+        if(Paren) ++cond->At;
+        std::string Name = cond->At < cond->Tokens.size() ? cond->Tokens[cond->At++] : "";
+        if(Paren && cond->At < cond->Tokens.size() && cond->Tokens[cond->At] == ")") ++cond->At;
+        return cond->Defines->count(Name) ? 1 : 0;
+    }
+    if(isdigit((u8)Token[0]) || Token[0] == '.') {
+        return atof(Token.c_str());
+    }
+
+    // NOTE(Jovan): Follows one level of aliasing, undefined names are 0 like in C
+    auto Found = cond->Defines->find(Token);
+    if(Found == cond->Defines->end()) {
+        return 0;
+    }
+    auto Alias = cond->Defines->find(Found->second);
+    return atof((Alias != cond->Defines->end() ? Alias->second : Found->second).c_str());
+}
+
+internal i32
+ConditionPrecedence(const std::string &op) {
+    if(op == "||") return 1;
+    if(op == "&&") return 2;
+    if(op == "==" || op == "!=") return 3;
+    if(op == "<" || op == ">" || op == "<=" || op == ">=") return 4;
+    if(op == "+" || op == "-") return 5;
+    if(op == "*" || op == "/") return 6;
+    return -1;
+}
+
+internal r64
+EvaluateCondition(cost_condition *cond, i32 precedence) {
+    r64 Left = EvaluateConditionPrimary(cond);
+    while(cond->At < cond->Tokens.size()) {
+        std::string Op = cond->Tokens[cond->At];
+        i32 OpPrecedence = ConditionPrecedence(Op);
+        if(OpPrecedence <= precedence) {
+            break;
+        }
+        ++cond->At;
+        r64 Right = EvaluateCondition(cond, OpPrecedence);
+        if(Op == "||") Left = Left || Right;
+        else if(Op == "&&") Left = Left && Right;
+        else if(Op == "==") Left = Left == Right;
+        else if(Op == "!=") Left = Left != Right;
+        else if(Op == "<") Left = Left < Right;
+        else if(Op == ">") Left = Left > Right;
+        else if(Op == "<=") Left = Left <= Right;
+        else if(Op == ">=") Left = Left >= Right;
+        else if(Op == "+") Left = Left + Right;
+        else if(Op == "-") Left = Left - Right;
+        else if(Op == "*") Left = Left * Right;
+        else if(Op == "/") Left = Right != 0 ? Left / Right : 0;
+    }
+    return Left;
+}
+
+internal void
+AppendCostTokens(const char *at, const char *end, u32 file, u32 line, std::vector<cost_token> &out) {
+    const char *Symbols[] = {"++", "--", "+=", "-=", "*=", "/=", "<=", ">=", "==", "!=", "&&", "||"};
+    while(at < end) {
+        if(isspace((u8)*at)) {
+            ++at;
+            continue;
+        }
+
+        cost_token Token;
+        Token.File = file;
+        Token.Line = line;
+        const char *Start = at;
+        if(isalpha((u8)*at) || *at == '_') {
+            while(at < end && IsIdentifierChar(*at)) ++at;
+            Token.Kind = CostToken_Identifier;
+        } else if(isdigit((u8)*at) || (*at == '.' && at + 1 < end && isdigit((u8)at[1]))) {
+            while(at < end && (IsIdentifierChar(*at) || *at == '.' ||
+                               ((*at == '-' || *at == '+') && (at[-1] == 'e' || at[-1] == 'E')))) ++at;
+            Token.Kind = CostToken_Number;
+        } else {
+            Token.Kind = CostToken_Symbol;
+            ++at;
+            for(const char *Symbol : Symbols) {
+                if(at < end && Start[0] == Symbol[0] && at[0] == Symbol[1]) {
+                    ++at;
+                    break;
+                }
+            }
+        }
+        Token.Text.assign(Start, at - Start);
+        out.push_back(Token);
+    }
+}
+
+// NOTE(Jovan): Strips comments, runs the conditionals and tracks #line so
+// every token knows where it came from
+internal std::vector<cost_token>
+TokenizeForCost(const std::string &source, cost_report *report) {
+    std::vector<cost_token> Tokens;
+    std::unordered_map<std::string, std::string> Defines;
+    struct conditional { b32 Active; b32 Taken; b32 ParentActive; };
+    std::vector<conditional> Conditionals;
+    b32 Active = true;
+
+    std::string Text = source;
+    for(size_t At = 0; At + 1 < Text.size(); ++At) {
+        if(Text[At] == '/' && Text[At + 1] == '/') {
+            while(At < Text.size() && Text[At] != '\n') Text[At++] = ' ';
+        } else if(Text[At] == '/' && Text[At + 1] == '*') {
+            while(At + 1 < Text.size() && !(Text[At] == '*' && Text[At + 1] == '/')) {
+                if(Text[At] != '\n') Text[At] = ' ';
+                ++At;
+            }
+            if(At + 1 < Text.size()) Text[At] = Text[At + 1] = ' ';
+        }
+    }
+
+    u32 File = 0, Line = 1;
+    size_t LineStart = 0;
+    while(LineStart < Text.size()) {
+        size_t LineEnd = Text.find('\n', LineStart);
+        if(LineEnd == std::string::npos) LineEnd = Text.size();
+        const char *At = Text.c_str() + LineStart;
+        const char *End = Text.c_str() + LineEnd;
+        while(At < End && isspace((u8)*At)) ++At;
+
+        u32 NextLine = Line + 1;
+        if(At < End && *At == '#') {
+            std::vector<cost_token> Directive;
+            AppendCostTokens(At + 1, End, File, Line, Directive);
+            std::string Name = Directive.empty() ? "" : Directive[0].Text;
+            std::vector<std::string> Args;
+            for(size_t TokenIndex = 1; TokenIndex < Directive.size(); ++TokenIndex) {
+                Args.push_back(Directive[TokenIndex].Text);
+            }
+
+            if(Name == "if" || Name == "ifdef" || Name == "ifndef") {
+                b32 Value;
+                if(Name == "if") {
+                    cost_condition Cond = {Args, 0, &Defines};
+                    Value = EvaluateCondition(&Cond, 0) != 0;
+                } else {
+                    Value = !Args.empty() && Defines.count(Args[0]);
+                    if(Name == "ifndef") Value = !Value;
+                }
+                Conditionals.push_back({Active && Value, Value, Active});
+                Active = Active && Value;
+            } else if(Name == "elif" && !Conditionals.empty()) {
+                conditional *Top = &Conditionals.back();
+                cost_condition Cond = {Args, 0, &Defines};
+                b32 Value = !Top->Taken && EvaluateCondition(&Cond, 0) != 0;
+                Top->Taken |= Value;
+                Active = Top->Active = Top->ParentActive && Value;
+            } else if(Name == "else" && !Conditionals.empty()) {
+                conditional *Top = &Conditionals.back();
+                Active = Top->Active = Top->ParentActive && !Top->Taken;
+                Top->Taken = true;
+            } else if(Name == "endif" && !Conditionals.empty()) {
+                Active = Conditionals.back().ParentActive;
+                Conditionals.pop_back();
+            } else if(Active && Name == "define" && !Args.empty()) {
+                Defines[Args[0]] = Args.size() == 2 ? Args[1] : "";
+                if(Args.size() == 2 && Directive[2].Kind == CostToken_Number) {
+                    report->Constants[Args[0]] = atof(Args[1].c_str());
+                }
+            } else if(Active && Name == "undef" && !Args.empty()) {
+                Defines.erase(Args[0]);
+                report->Constants.erase(Args[0]);
+            } else if(Name == "line" && !Args.empty()) {
+                NextLine = (u32)atoi(Args[0].c_str());
+                if(Args.size() > 1) File = (u32)atoi(Args[1].c_str());
+            }
+        } else if(Active) {
+            AppendCostTokens(At, End, File, Line, Tokens);
+        }
+
+        Line = NextLine;
+        LineStart = LineEnd + 1;
+    }
+
+    // NOTE(Jovan): Defines with plain numbers are substituted so loop bounds
+    // and constants written through macros still resolve
+    for(cost_token &Token : Tokens) {
+        if(Token.Kind == CostToken_Identifier) {
+            auto Found = Defines.find(Token.Text);
+            if(Found != Defines.end() && report->Constants.count(Token.Text)) {
+                Token.Kind = CostToken_Number;
+                Token.Text = Found->second;
+            }
+        }
+    }
+    return Tokens;
+}
+
+internal size_t
+MatchingToken(const std::vector<cost_token> &tokens, size_t open) {
+    const std::string &Open = tokens[open].Text;
+    std::string Close = Open == "(" ? ")" : Open == "{" ? "}" : "]";
+    i32 Depth = 0;
+    for(size_t At = open; At < tokens.size(); ++At) {
+        if(tokens[At].Text == Open) ++Depth;
+        else if(tokens[At].Text == Close && --Depth == 0) return At;
+    }
+    return tokens.size();
+}
+
+// NOTE(Jovan): A loop body is either a block or a single statement
+internal size_t
+StatementEnd(const std::vector<cost_token> &tokens, size_t begin) {
+    if(begin < tokens.size() && tokens[begin].Text == "{") {
+        return MatchingToken(tokens, begin) + 1;
+    }
+    for(size_t At = begin; At < tokens.size(); ++At) {
+        if(tokens[At].Text == "(" || tokens[At].Text == "{") {
+            At = MatchingToken(tokens, At);
+        } else if(tokens[At].Text == ";") {
+            return At + 1;
+        }
+    }
+    return tokens.size();
+}
+
+internal b32
+CostValue(const cost_report *report, const cost_token &token, r64 *out) {
+    if(token.Kind == CostToken_Number) {
+        *out = atof(token.Text.c_str());
+        return true;
+    }
+    auto Found = report->Constants.find(token.Text);
+    if(Found != report->Constants.end()) {
+        *out = Found->second;
+        return true;
+    }
+    return false;
+}
+
+// NOTE(Jovan): Handles the "for(int i = A; i < B; i += C)" family, returns a
+// negative count when the bounds aren't compile time constants
+internal r64
+ForTripCount(const cost_report *report, const std::vector<cost_token> &tokens, size_t begin, size_t end) {
+    size_t FirstSemi = end, SecondSemi = end;
+    for(size_t At = begin; At < end; ++At) {
+        if(tokens[At].Text == ";") {
+            if(FirstSemi == end) FirstSemi = At;
+            else if(SecondSemi == end) SecondSemi = At;
+        }
+    }
+    if(SecondSemi == end) {
+        return -1;
+    }
+
+    std::string Var;
+    r64 Start = 0;
+    for(size_t At = begin; At + 2 <= FirstSemi; ++At) {
+        if(tokens[At].Kind == CostToken_Identifier && tokens[At + 1].Text == "=" && At + 3 == FirstSemi &&
+           CostValue(report, tokens[At + 2], &Start)) {
+            Var = tokens[At].Text;
+        }
+    }
+
+    r64 Limit = 0;
+    std::string Compare;
+    if(Var.empty() || SecondSemi - FirstSemi != 4 || tokens[FirstSemi + 1].Text != Var ||
+       !CostValue(report, tokens[FirstSemi + 3], &Limit)) {
+        return -1;
+    }
+    Compare = tokens[FirstSemi + 2].Text;
+
+    r64 Step = 0;
+    size_t Incr = SecondSemi + 1;
+    if(end - Incr == 2 && (tokens[Incr].Text == Var || tokens[Incr + 1].Text == Var)) {
+        std::string Op = tokens[Incr].Text == Var ? tokens[Incr + 1].Text : tokens[Incr].Text;
+        Step = Op == "++" ? 1 : Op == "--" ? -1 : 0;
+    } else if(end - Incr == 3 && tokens[Incr].Text == Var && CostValue(report, tokens[Incr + 2], &Step)) {
+        if(tokens[Incr + 1].Text == "-=") Step = -Step;
+        else if(tokens[Incr + 1].Text != "+=") Step = 0;
+    }
+    if(Step == 0) {
+        return -1;
+    }
+
+    r64 Span = (Limit - Start) / Step;
+    r64 Count;
+    if(Compare == "<" || Compare == ">" || Compare == "!=") Count = ceil(Span);
+    else if(Compare == "<=" || Compare == ">=") Count = floor(Span) + 1;
+    else return -1;
+    return Count > 0 ? Count : 0;
+}
+
+internal const cost_builtin*
+FindCostBuiltin(const std::string &name) {
+    for(const cost_builtin &Builtin : G_COST_BUILTINS) {
+        if(name == Builtin.Name) {
+            return &Builtin;
+        }
+    }
+    return 0;
+}
+
+internal b32
+IsCostKeyword(const std::string &name) {
+    for(const char *Keyword : G_COST_KEYWORDS) {
+        if(name == Keyword) {
+            return true;
+        }
+    }
+    return false;
+}
+
+internal void
+AnalyzeCostRange(cost_report *report, cost_function *function, const std::vector<cost_token> &tokens,
+                 size_t begin, size_t end, r64 multiplier, u32 loopDepth) {
+    for(size_t At = begin; At < end; ++At) {
+        const cost_token &Token = tokens[At];
+        if(Token.Kind == CostToken_Identifier &&
+           (Token.Text == "for" || Token.Text == "while" || Token.Text == "do")) {
+            size_t BodyBegin, BodyEnd, Next;
+            r64 Trips = -1;
+            if(Token.Text == "do") {
+                BodyBegin = At + 1;
+                BodyEnd = StatementEnd(tokens, BodyBegin);
+                Next = BodyEnd;
+                if(Next < end && tokens[Next].Text == "while" && Next + 1 < end) {
+                    Next = StatementEnd(tokens, Next + 1);
+                }
+            } else {
+                size_t HeaderEnd = At + 1 < end ? MatchingToken(tokens, At + 1) : end;
+                if(Token.Text == "for") {
+                    Trips = ForTripCount(report, tokens, At + 2, HeaderEnd);
+                }
+                BodyBegin = HeaderEnd + 1;
+                BodyEnd = StatementEnd(tokens, BodyBegin);
+                Next = BodyEnd;
+            }
+
+            ++function->Loops;
+            if(Trips < 0) {
+                report->Flags.push_back({"unbounded-loop", function->Name, Token.File, Token.Line});
+                Trips = COST_UNKNOWN_TRIPS;
+            }
+            AnalyzeCostRange(report, function, tokens, BodyBegin, std::min(BodyEnd, end),
+                             multiplier * Trips, loopDepth + 1);
+            At = Next - 1;
+            continue;
+        }
+
+        if(Token.Kind == CostToken_Identifier && At + 1 < end && tokens[At + 1].Text == "(") {
+            const cost_builtin *Builtin = FindCostBuiltin(Token.Text);
+            if(Builtin) {
+                r64 Ops = Builtin->Ops * multiplier;
+                if(Builtin->Category == Cost_Texture) {
+                    function->Self.Texture += Ops;
+                    if(loopDepth) {
+                        report->Flags.push_back({"texture-in-loop", function->Name, Token.File, Token.Line});
+                    }
+                } else if(Builtin->Category == Cost_Transcendental) {
+                    function->Self.Transcendental += Ops;
+                } else {
+                    function->Self.ALU += Ops;
+                }
+            } else if(!IsCostKeyword(Token.Text)) {
+                function->Calls.push_back({Token.Text, multiplier, loopDepth > 0, Token.File, Token.Line});
+            }
+            continue;
+        }
+
+        if(Token.Kind == CostToken_Symbol) {
+            const char *ALUOps[] = {"+", "-", "*", "/", "%", "+=", "-=", "*=", "/=", "++", "--",
+                                    "<", ">", "<=", ">=", "==", "!=", "&&", "||", "!"};
+            for(const char *Op : ALUOps) {
+                if(Token.Text == Op) {
+                    function->Self.ALU += multiplier;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+internal cost_function*
+FindCostFunction(cost_report *report, const std::string &name) {
+    for(cost_function &Function : report->Functions) {
+        if(Function.Name == name) {
+            return &Function;
+        }
+    }
+    return 0;
+}
+
+internal b32
+FunctionFetchesTextures(cost_report *report, cost_function *function, u32 depth = 0) {
+    if(function->Self.Texture > 0) {
+        return true;
+    }
+    for(const cost_call &Call : function->Calls) {
+        cost_function *Callee = FindCostFunction(report, Call.Name);
+        if(Callee && Callee != function && depth < 32 && FunctionFetchesTextures(report, Callee, depth + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// NOTE(Jovan): GLSL has no recursion so inlining callees is a plain walk,
+// the depth check only guards against shaders that wouldn't compile anyway
+internal cost_counts
+ResolveFunctionCost(cost_report *report, cost_function *function, u32 depth = 0) {
+    if(function->Resolved || depth > 32) {
+        return function->Total;
+    }
+
+    function->Total = function->Self;
+    for(const cost_call &Call : function->Calls) {
+        cost_function *Callee = FindCostFunction(report, Call.Name);
+        if(!Callee || Callee == function) {
+            continue;
+        }
+        cost_counts Inner = ResolveFunctionCost(report, Callee, depth + 1);
+        r64 Count = Call.Count;
+        function->Total.ALU += Inner.ALU * Count;
+        function->Total.Texture += Inner.Texture * Count;
+        function->Total.Transcendental += Inner.Transcendental * Count;
+    }
+    function->Resolved = true;
+    return function->Total;
+}
+
+internal cost_report
+AnalyzeShaderCost(const std::string &source) {
+    cost_report Report;
+    std::vector<cost_token> Tokens = TokenizeForCost(source, &Report);
+
+    // NOTE(Jovan): Top level "const int N = 64;" style constants count as
+    // loop bounds too
+    for(size_t At = 0; At + 4 < Tokens.size(); ++At) {
+        if(Tokens[At].Text == "const" && Tokens[At + 2].Kind == CostToken_Identifier &&
+           Tokens[At + 3].Text == "=" && Tokens[At + 4].Kind == CostToken_Number) {
+            Report.Constants[Tokens[At + 2].Text] = atof(Tokens[At + 4].Text.c_str());
+        }
+    }
+
+    std::vector<std::pair<size_t, size_t>> Bodies;
+    for(size_t At = 0; At + 1 < Tokens.size(); ++At) {
+        if(Tokens[At].Text == "{") {
+            At = MatchingToken(Tokens, At);
+            continue;
+        }
+        if(Tokens[At].Kind != CostToken_Identifier || Tokens[At + 1].Text != "(" || IsCostKeyword(Tokens[At].Text)) {
+            continue;
+        }
+
+        size_t ParamsEnd = MatchingToken(Tokens, At + 1);
+        if(ParamsEnd + 1 >= Tokens.size() || Tokens[ParamsEnd + 1].Text != "{") {
+            At = ParamsEnd;
+            continue;
+        }
+
+        cost_function Function = {};
+        Function.Name = Tokens[At].Text;
+        size_t BodyEnd = MatchingToken(Tokens, ParamsEnd + 1);
+        Report.Functions.push_back(Function);
+        Bodies.push_back({ParamsEnd + 2, std::min(BodyEnd, Tokens.size())});
+        At = BodyEnd;
+    }
+
+    for(size_t FunctionIndex = 0; FunctionIndex < Report.Functions.size(); ++FunctionIndex) {
+        AnalyzeCostRange(&Report, &Report.Functions[FunctionIndex], Tokens,
+                         Bodies[FunctionIndex].first, Bodies[FunctionIndex].second, 1.0, 0);
+    }
+
+    // NOTE(Jovan): Calls inside loops are where fetches usually hide, they get
+    // flagged if anything down the call chain samples
+    for(cost_function &Function : Report.Functions) {
+        for(cost_call &Call : Function.Calls) {
+            if(!Call.InLoop) {
+                continue;
+            }
+            cost_function *Callee = FindCostFunction(&Report, Call.Name);
+            if(Callee && FunctionFetchesTextures(&Report, Callee)) {
+                Report.Flags.push_back({"texture-in-loop via " + Call.Name, Function.Name, Call.File, Call.Line});
+            }
+        }
+    }
+
+    for(cost_function &Function : Report.Functions) {
+        ResolveFunctionCost(&Report, &Function);
+    }
+    return Report;
+}
+
+internal void
+PrintCostCounts(const cost_counts &counts) {
+    std::cout << ",\"alu\":" << counts.ALU << ",\"texture\":" << counts.Texture
+              << ",\"transcendental\":" << counts.Transcendental << ",\"cost\":" << CostScore(counts);
+}
+
+// NOTE(Jovan): --cost mode, one JSON line per function and a total per
+// shader and variant, same shape as the --compile-only output
+internal i32
+PrintShaderCosts(const std::vector<std::string> &paths, const std::vector<std::string> &includeDirs) {
+    shader_preprocessor Preprocessor;
+    Preprocessor.IncludeDirs = includeDirs;
+
+    i32 Result = 0;
+    for(const std::string &Path : paths) {
+        preprocessed_source Source;
+        if(!PreprocessShader(&Preprocessor, Path, &Source)) {
+            std::cout << "{\"file\":\"" << JsonEscape(Path) << "\",\"status\":\"error\",\"log\":\""
+                      << JsonEscape(Preprocessor.LastError) << "\"}" << std::endl;
+            Result = 1;
+            continue;
+        }
+
+        variant_set Set = {};
+        Set.Axes = Source.Variants;
+        Set.KeyBits = LayoutVariantAxes(Set.Axes);
+        for(u32 Key = 0; Key < (1u << Set.KeyBits); ++Key) {
+            if(!IsValidVariantKey(&Set, Key)) {
+                continue;
+            }
+
+            std::string Variant = Set.Axes.empty() ? "" : VariantKeyName(&Set, Key);
+            preprocessed_source Injected = InjectVariantDefines(Source, VariantDefines(&Set, Key));
+            cost_report Report = AnalyzeShaderCost(InlineLinkedLibraries(&Injected));
+            std::string Prefix = "{\"file\":\"" + JsonEscape(Path) + "\",\"variant\":\"" + JsonEscape(Variant) + "\"";
+
+            for(const cost_function &Function : Report.Functions) {
+                std::cout << Prefix << ",\"function\":\"" << JsonEscape(Function.Name) << "\""
+                          << ",\"loops\":" << Function.Loops;
+                PrintCostCounts(Function.Total);
+                std::cout << "}" << std::endl;
+            }
+
+            cost_function *Main = FindCostFunction(&Report, "main");
+            std::cout << Prefix << ",\"total\":true";
+            PrintCostCounts(Main ? Main->Total : cost_counts{});
+            std::cout << ",\"flags\":[";
+            for(size_t FlagIndex = 0; FlagIndex < Report.Flags.size(); ++FlagIndex) {
+                const cost_flag &Flag = Report.Flags[FlagIndex];
+                std::string At = Flag.Line && Flag.File < Injected.Files.size() ?
+                                 Injected.Files[Flag.File] + ":" + std::to_string(Flag.Line) : "";
+                std::cout << (FlagIndex ? "," : "") << "{\"kind\":\"" << JsonEscape(Flag.Kind)
+                          << "\",\"function\":\"" << JsonEscape(Flag.Function)
+                          << "\",\"at\":\"" << JsonEscape(At) << "\"}";
+            }
+            std::cout << "]}" << std::endl;
+        }
+    }
+    return Result;
+}
@@ -0,0 +1,206 @@
+// NOTE(Jovan): Dynamic resolution. The shader draws into the corner of a
+// window sized target and that corner gets upscaled to the window with a
+// Catmull-Rom filter, so changing the scale never reallocates anything. The
+// draw is timed with timestamps read back a few frames late, a PI controller
+// steers the scale to keep it at the budget. Cost goes with the area, so it
+// works on the square root of budget over time. Small errors are ignored and
+// the scale only moves every few frames, otherwise it keeps chasing the lag
+// of its own measurements
+
+#define DYNRES_DEFAULT_BUDGET_MS 12.0
+#define DYNRES_MIN_SCALE 0.25
+#define DYNRES_MAX_SCALE 1.0
+#define DYNRES_QUERY_FRAMES 4
+#define DYNRES_UPDATE_FRAMES 4
+#define DYNRES_DEADBAND 0.05
+#define DYNRES_KP 0.25
+#define DYNRES_KI 0.5
+#define DYNRES_SMOOTHING 0.2
+
+global const char *UPSCALE_FRAGMENT_SOURCE = R"(#version 330 core
+uniform sampler2D Source;
+uniform vec2 SourceSize;
+uniform vec2 OutputSize;
+out vec4 FragColor;
+
+vec4 Tap(vec2 p) {
+    return texture(Source, clamp(p, vec2(0.5), SourceSize - 0.5) / vec2(textureSize(Source, 0)));
+}
+
+// NOTE(Jovan): Catmull-Rom in 9 bilinear taps, the middle two weights of
+// each axis are folded into one sample between them
+void main() {
+    vec2 P = gl_FragCoord.xy * SourceSize / OutputSize - 0.5;
+    vec2 Center = floor(P) + 0.5;
+    vec2 F = P - floor(P);
+    vec2 W0 = F * (-0.5 + F * (1.0 - 0.5 * F));
+    vec2 W1 = 1.0 + F * F * (-2.5 + 1.5 * F);
+    vec2 W2 = F * (0.5 + F * (2.0 - 1.5 * F));
+    vec2 W3 = F * F * (-0.5 + 0.5 * F);
+    vec2 W12 = W1 + W2;
+    vec2 P0 = Center - 1.0;
+    vec2 P12 = Center + W2 / W12;
+    vec2 P3 = Center + 2.0;
+
+    vec4 Color = Tap(vec2(P0.x, P0.y)) * W0.x * W0.y + Tap(vec2(P12.x, P0.y)) * W12.x * W0.y +
+                 Tap(vec2(P3.x, P0.y)) * W3.x * W0.y +
+                 Tap(vec2(P0.x, P12.y)) * W0.x * W12.y + Tap(vec2(P12.x, P12.y)) * W12.x * W12.y +
+                 Tap(vec2(P3.x, P12.y)) * W3.x * W12.y +
+                 Tap(vec2(P0.x, P3.y)) * W0.x * W3.y + Tap(vec2(P12.x, P3.y)) * W12.x * W3.y +
+                 Tap(vec2(P3.x, P3.y)) * W3.x * W3.y;
+    FragColor = max(Color, vec4(0.0));
+}
+)";
+
+struct dynamic_resolution {
+    b32 Enabled;
+    r64 BudgetMs;
+
+    u32 UpscaleProgram;
+    i32 SourceSizeLocation;
+    i32 OutputSizeLocation;
+    u32 Framebuffer;
+    u32 Texture;
+    u32 Depth;
+    i32 TargetWidth;
+    i32 TargetHeight;
+    i32 RenderWidth;
+    i32 RenderHeight;
+
+    u32 Queries[DYNRES_QUERY_FRAMES * 2];
+    b32 QueryPending[DYNRES_QUERY_FRAMES];
+    u32 NextQuery;
+    b32 Timing;
+
+    r64 Scale;
+    r64 PreviousError;
+    r64 SmoothedMs;
+    u32 Frames;
+};
+
+internal void
+InitDynamicResolution(dynamic_resolution *dyn) {
+    dyn->UpscaleProgram = BuildFullscreenProgram(UPSCALE_FRAGMENT_SOURCE, "upscale");
+    if(dyn->UpscaleProgram) {
+        glUseProgram(dyn->UpscaleProgram);
+        glUniform1i(glGetUniformLocation(dyn->UpscaleProgram, "Source"), 0);
+        dyn->SourceSizeLocation = glGetUniformLocation(dyn->UpscaleProgram, "SourceSize");
+        dyn->OutputSizeLocation = glGetUniformLocation(dyn->UpscaleProgram, "OutputSize");
+    }
+    glGenFramebuffers(1, &dyn->Framebuffer);
+    glGenTextures(1, &dyn->Texture);
+    glGenRenderbuffers(1, &dyn->Depth);
+    glGenQueries(DYNRES_QUERY_FRAMES * 2, dyn->Queries);
+    dyn->Scale = DYNRES_MAX_SCALE;
+}
+
+internal void
+CollectDynamicResolutionQueries(dynamic_resolution *dyn) {
+    for(u32 QueryIndex = 0; QueryIndex < DYNRES_QUERY_FRAMES; ++QueryIndex) {
+        if(!dyn->QueryPending[QueryIndex]) {
+            continue;
+        }
+        i32 Available = 0;
+        glGetQueryObjectiv(dyn->Queries[QueryIndex * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &Available);
+        if(!Available) {
+            continue;
+        }
+
+        GLuint64 Begin, End;
+        glGetQueryObjectui64v(dyn->Queries[QueryIndex * 2], GL_QUERY_RESULT, &Begin);
+        glGetQueryObjectui64v(dyn->Queries[QueryIndex * 2 + 1], GL_QUERY_RESULT, &End);
+        dyn->QueryPending[QueryIndex] = false;
+        r64 Milliseconds = (End - Begin) / 1e6;
+        dyn->SmoothedMs = dyn->SmoothedMs > 0.0 ? dyn->SmoothedMs + DYNRES_SMOOTHING * (Milliseconds - dyn->SmoothedMs)
+                                                : Milliseconds;
+    }
+}
+
+internal void
+UpdateResolutionScale(dynamic_resolution *dyn) {
+    CollectDynamicResolutionQueries(dyn);
+    if(dyn->SmoothedMs <= 0.0 || ++dyn->Frames % DYNRES_UPDATE_FRAMES) {
+        return;
+    }
+
+    r64 Error = sqrt(dyn->BudgetMs / dyn->SmoothedMs) - 1.0;
+    r64 Change = DYNRES_KP * (Error - dyn->PreviousError) + DYNRES_KI * Error;
+    dyn->PreviousError = Error;
+    if(fabs(Error) < DYNRES_DEADBAND) {
+        return;
+    }
+
+    // NOTE(Jovan): Velocity form, the scale itself is the integral so there's
+    // nothing to wind up while it's pinned against a clamp
+    dyn->Scale = std::min(std::max(dyn->Scale * (1.0 + Change), DYNRES_MIN_SCALE), DYNRES_MAX_SCALE);
+}
+
+// NOTE(Jovan): Decides this frame's render size, call before the inputs get
+// set since they're in render pixels
+internal void
+BeginDynamicResolution(dynamic_resolution *dyn, i32 width, i32 height) {
+    if(dyn->TargetWidth != width || dyn->TargetHeight != height) {
+        dyn->TargetWidth = width;
+        dyn->TargetHeight = height;
+        glBindTexture(GL_TEXTURE_2D, dyn->Texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindRenderbuffer(GL_RENDERBUFFER, dyn->Depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glBindFramebuffer(GL_FRAMEBUFFER, dyn->Framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dyn->Texture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, dyn->Depth);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    UpdateResolutionScale(dyn);
+    dyn->RenderWidth = std::max(1, (i32)round(width * dyn->Scale));
+    dyn->RenderHeight = std::max(1, (i32)round(height * dyn->Scale));
+}
+
+internal void
+BeginScaledDraw(dynamic_resolution *dyn) {
+    glBindFramebuffer(GL_FRAMEBUFFER, dyn->Framebuffer);
+    glViewport(0, 0, dyn->RenderWidth, dyn->RenderHeight);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    dyn->Timing = !dyn->QueryPending[dyn->NextQuery];
+    if(dyn->Timing) {
+        glQueryCounter(dyn->Queries[dyn->NextQuery * 2], GL_TIMESTAMP);
+    }
+}
+
+internal void
+EndScaledDraw(dynamic_resolution *dyn, u32 vao) {
+    if(dyn->Timing) {
+        glQueryCounter(dyn->Queries[dyn->NextQuery * 2 + 1], GL_TIMESTAMP);
+        dyn->QueryPending[dyn->NextQuery] = true;
+        dyn->NextQuery = (dyn->NextQuery + 1) % DYNRES_QUERY_FRAMES;
+        dyn->Timing = false;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, dyn->TargetWidth, dyn->TargetHeight);
+    if(!dyn->UpscaleProgram) {
+        return;
+    }
+    glUseProgram(dyn->UpscaleProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, dyn->Texture);
+    glUniform2f(dyn->SourceSizeLocation, (r32)dyn->RenderWidth, (r32)dyn->RenderHeight);
+    glUniform2f(dyn->OutputSizeLocation, (r32)dyn->TargetWidth, (r32)dyn->TargetHeight);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+internal void
+ShutdownDynamicResolution(dynamic_resolution *dyn) {
+    if(dyn->UpscaleProgram) glDeleteProgram(dyn->UpscaleProgram);
+    glDeleteFramebuffers(1, &dyn->Framebuffer);
+    glDeleteTextures(1, &dyn->Texture);
+    glDeleteRenderbuffers(1, &dyn->Depth);
+    glDeleteQueries(DYNRES_QUERY_FRAMES * 2, dyn->Queries);
+}
@@ -0,0 +1,129 @@
+// NOTE(Jovan): Headless OpenGL through EGL. Prefers Mesa's surfaceless
+// platform so nothing needs a running X or Wayland session, contexts are
+// made current without a surface where the driver allows it
+
+struct egl_device {
+    EGLDisplay Display;
+    EGLConfig Config;
+    b32 Surfaceless;
+};
+
+struct egl_context {
+    EGLContext Context;
+    EGLSurface Surface;
+};
+
+internal b32
+HasEGLExtension(EGLDisplay display, const char *name) {
+    const char *Extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if(!Extensions) {
+        return false;
+    }
+
+    size_t Length = strlen(name);
+    for(const char *At = Extensions; (At = strstr(At, name)); At += Length) {
+        if((At == Extensions || At[-1] == ' ') && (At[Length] == ' ' || At[Length] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+internal b32
+InitHeadlessDevice(egl_device *device) {
+    device->Display = EGL_NO_DISPLAY;
+    if(HasEGLExtension(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC GetPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if(GetPlatformDisplay) {
+            device->Display = GetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, 0);
+        }
+    }
+    if(device->Display == EGL_NO_DISPLAY) {
+        device->Display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    EGLint Major, Minor;
+    if(device->Display == EGL_NO_DISPLAY || !eglInitialize(device->Display, &Major, &Minor)) {
+        std::cerr << "[Err] EGL: Failed initializing a display" << std::endl;
+        return false;
+    }
+
+    if(!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "[Err] EGL: Desktop OpenGL not supported" << std::endl;
+        eglTerminate(device->Display);
+        return false;
+    }
+
+    EGLint ConfigAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+    EGLint ConfigCount = 0;
+    device->Config = 0;
+    eglChooseConfig(device->Display, ConfigAttribs, &device->Config, 1, &ConfigCount);
+    if(!ConfigCount && !HasEGLExtension(device->Display, "EGL_KHR_no_config_context")) {
+        std::cerr << "[Err] EGL: No usable config" << std::endl;
+        eglTerminate(device->Display);
+        return false;
+    }
+    if(!ConfigCount) {
+        device->Config = EGL_NO_CONFIG_KHR;
+    }
+
+    device->Surfaceless = HasEGLExtension(device->Display, "EGL_KHR_surfaceless_context");
+    return true;
+}
+
+// NOTE(Jovan): Without surfaceless support every context gets a 1x1 pbuffer
+// to be current on, nothing ever renders to it
+internal b32
+CreateHeadlessContext(egl_device *device, egl_context *context, EGLContext share = EGL_NO_CONTEXT) {
+    EGLint ContextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context->Surface = EGL_NO_SURFACE;
+    context->Context = eglCreateContext(device->Display, device->Config, share, ContextAttribs);
+    if(context->Context == EGL_NO_CONTEXT) {
+        std::cerr << "[Err] EGL: Failed creating a 3.3 core context" << std::endl;
+        return false;
+    }
+
+    if(!device->Surfaceless && device->Config != EGL_NO_CONFIG_KHR) {
+        EGLint SurfaceAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        context->Surface = eglCreatePbufferSurface(device->Display, device->Config, SurfaceAttribs);
+    }
+    return true;
+}
+
+internal b32
+MakeHeadlessContextCurrent(egl_device *device, egl_context *context) {
+    if(!context) {
+        return eglMakeCurrent(device->Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+    return eglMakeCurrent(device->Display, context->Surface, context->Surface, context->Context);
+}
+
+internal void
+DestroyHeadlessContext(egl_device *device, egl_context *context) {
+    if(context->Surface != EGL_NO_SURFACE) {
+        eglDestroySurface(device->Display, context->Surface);
+    }
+    if(context->Context != EGL_NO_CONTEXT) {
+        eglDestroyContext(device->Display, context->Context);
+    }
+    context->Surface = EGL_NO_SURFACE;
+    context->Context = EGL_NO_CONTEXT;
+}
+
+internal void
+ShutdownHeadlessDevice(egl_device *device) {
+    eglMakeCurrent(device->Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglTerminate(device->Display);
+    device->Display = EGL_NO_DISPLAY;
+}
@@ -0,0 +1,575 @@
+// NOTE(Jovan): Render graph. A ".graph" file lists buffer passes, each a
+// fragment shader drawing into its own target, and the image pass that ends
+// up on screen. Passes read each other through "uniform sampler2D ChannelN"
+// with the sizes in "uniform vec2 ChannelResolution[4]":
+//
+//     # Trail feeding on itself, blurred and added back on top
+//     pass Trail graph/trail.frag
+//         format rgba16f
+//         input 0 Trail
+//     pass BlurX graph/blur_x.frag
+//         scale 0.5
+//         input 0 Trail
+//     image graph/image.frag
+//         input 0 Trail
+//         input 1 BlurX
+//
+// Paths are relative to the graph file. The passes get sorted so everything
+// is drawn after what it reads. A pass reading itself, or any input marked
+// "previous", gets last frame's result instead, those targets are double
+// buffered and kept around. The rest only live from their pass to their last
+// reader, targets of the same size and format get handed from one of those
+// to the next once it's done with them
+
+#define GRAPH_MAX_INPUTS 4
+#define GRAPH_NO_PASS -1
+
+enum graph_format {
+    GraphFormat_RGBA8,
+    GraphFormat_RGBA16F,
+    GraphFormat_RGBA32F,
+};
+
+struct graph_input {
+    std::string Source;
+    i32 Pass;
+    b32 Previous;
+};
+
+struct graph_pass {
+    std::string Name;
+    std::string FragmentPath;
+    graph_format Format;
+    r32 Scale;
+    graph_input Inputs[GRAPH_MAX_INPUTS];
+
+    variant_set Shader;
+    uniform_table Uniforms;
+    standard_uniforms Standard;
+    u32 ChannelUniforms[GRAPH_MAX_INPUTS];
+    u32 ChannelResolution;
+    u32 ProgramID;
+
+    b32 Used;
+    b32 Persistent;
+    b32 Private;
+    i32 LastReader;
+    i32 Width;
+    i32 Height;
+    i32 Targets[2];
+    u32 Current;
+};
+
+struct graph_target {
+    u32 Texture;
+    u32 Framebuffer;
+    graph_format Format;
+    i32 Width;
+    i32 Height;
+    i32 BusyUntil;
+};
+
+struct render_graph {
+    std::string Path;
+    std::vector<graph_pass> Passes;
+    std::vector<u32> Order;
+    std::vector<graph_target> Targets;
+    graph_pass Image;
+    i32 Width;
+    i32 Height;
+};
+
+internal b32
+ParseGraphFormat(const std::string &name, graph_format *out) {
+    if(name == "rgba8") {
+        *out = GraphFormat_RGBA8;
+    } else if(name == "rgba16f") {
+        *out = GraphFormat_RGBA16F;
+    } else if(name == "rgba32f") {
+        *out = GraphFormat_RGBA32F;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+internal u32
+GraphFormatBytes(graph_format format) {
+    switch(format) {
+        case GraphFormat_RGBA8: return 4;
+        case GraphFormat_RGBA16F: return 8;
+        case GraphFormat_RGBA32F: return 16;
+    }
+    return 4;
+}
+
+internal i32
+FindGraphPass(const render_graph *graph, const std::string &name) {
+    for(u32 PassIndex = 0; PassIndex < graph->Passes.size(); ++PassIndex) {
+        if(graph->Passes[PassIndex].Name == name) {
+            return (i32)PassIndex;
+        }
+    }
+    return GRAPH_NO_PASS;
+}
+
+internal void
+InitGraphPass(graph_pass *pass, const std::string &name, const std::string &path) {
+    pass->Name = name;
+    pass->FragmentPath = path;
+    pass->Format = GraphFormat_RGBA8;
+    pass->Scale = 1.0f;
+    for(graph_input &Input : pass->Inputs) {
+        Input.Pass = GRAPH_NO_PASS;
+        Input.Previous = false;
+    }
+    pass->Targets[0] = pass->Targets[1] = GRAPH_NO_PASS;
+}
+
+internal b32
+ParseRenderGraph(render_graph *graph, const std::string &text) {
+    std::string Dir, Name;
+    SplitPath(graph->Path, Dir, Name);
+    graph_pass *Pass = 0;
+    b32 HaveImage = false;
+    u32 LineNumber = 0;
+    for(size_t At = 0; At < text.size(); ++LineNumber) {
+        size_t LineEnd = text.find('\n', At);
+        if(LineEnd == std::string::npos) LineEnd = text.size();
+        size_t Comment = text.find('#', At);
+        std::vector<std::string> Words = SplitWords(text.c_str() + At, text.c_str() + std::min(LineEnd, Comment));
+        At = LineEnd + 1;
+        if(Words.empty()) {
+            continue;
+        }
+
+        std::string Where = graph->Path + ":" + std::to_string(LineNumber + 1) + ": ";
+        if(Words[0] == "pass" && Words.size() == 3) {
+            if(FindGraphPass(graph, Words[1]) != GRAPH_NO_PASS) {
+                std::cerr << "[Err] Graph: " << Where << "There already is a pass called " << Words[1] << std::endl;
+                return false;
+            }
+            graph->Passes.emplace_back();
+            Pass = &graph->Passes.back();
+            InitGraphPass(Pass, Words[1], NormalizePath(Dir + "/" + Words[2]));
+        } else if(Words[0] == "image" && Words.size() == 2 && !HaveImage) {
+            Pass = &graph->Image;
+            InitGraphPass(Pass, "Image", NormalizePath(Dir + "/" + Words[1]));
+            HaveImage = true;
+        } else if(!Pass) {
+            std::cerr << "[Err] Graph: " << Where << "Expected \"pass <name> <shader>\" or \"image <shader>\"" << std::endl;
+            return false;
+        } else if(Words[0] == "input" && (Words.size() == 3 || (Words.size() == 4 && Words[3] == "previous"))) {
+            i32 Channel = atoi(Words[1].c_str());
+            if(!IsNumber(Words[1]) || Channel < 0 || Channel >= GRAPH_MAX_INPUTS) {
+                std::cerr << "[Err] Graph: " << Where << "Channels go from 0 to " << GRAPH_MAX_INPUTS - 1 << std::endl;
+                return false;
+            }
+            Pass->Inputs[Channel].Source = Words[2];
+            Pass->Inputs[Channel].Previous = Words.size() == 4;
+        } else if(Words[0] == "format" && Words.size() == 2 && Pass != &graph->Image) {
+            if(!ParseGraphFormat(Words[1], &Pass->Format)) {
+                std::cerr << "[Err] Graph: " << Where << "Unknown format " << Words[1]
+                          << ", expected rgba8, rgba16f or rgba32f" << std::endl;
+                return false;
+            }
+        } else if(Words[0] == "scale" && Words.size() == 2 && Pass != &graph->Image) {
+            Pass->Scale = (r32)atof(Words[1].c_str());
+            if(!IsNumber(Words[1]) || Pass->Scale <= 0.0f || Pass->Scale > 4.0f) {
+                std::cerr << "[Err] Graph: " << Where << "Scale has to be above 0 and at most 4" << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "[Err] Graph: " << Where << "Don't know what to do with \"" << Words[0] << "\" here" << std::endl;
+            return false;
+        }
+    }
+
+    if(!HaveImage) {
+        std::cerr << "[Err] Graph: " << graph->Path << " has no image pass" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+internal b32
+ResolveGraphInputs(render_graph *graph, graph_pass *pass) {
+    for(graph_input &Input : pass->Inputs) {
+        if(Input.Source.empty()) {
+            continue;
+        }
+        Input.Pass = FindGraphPass(graph, Input.Source);
+        if(Input.Pass == GRAPH_NO_PASS) {
+            std::cerr << "[Err] Graph: " << pass->Name << " reads " << Input.Source << " which isn't a pass" << std::endl;
+            return false;
+        }
+        graph_pass *Source = &graph->Passes[Input.Pass];
+        if(Source == pass || Input.Previous) {
+            Input.Previous = true;
+            Source->Persistent = true;
+        }
+    }
+    return true;
+}
+
+internal void
+MarkGraphPassUsed(render_graph *graph, const graph_pass *pass) {
+    for(const graph_input &Input : pass->Inputs) {
+        if(Input.Pass != GRAPH_NO_PASS && !graph->Passes[Input.Pass].Used) {
+            graph->Passes[Input.Pass].Used = true;
+            MarkGraphPassUsed(graph, &graph->Passes[Input.Pass]);
+        }
+    }
+}
+
+// NOTE(Jovan): Kahn's algorithm, among passes that are ready the one declared
+// first goes first so the order stays the one in the file where it can.
+// Reads of last frame's result don't constrain anything
+internal b32
+SortRenderGraph(render_graph *graph) {
+    u32 PassCount = (u32)graph->Passes.size();
+    std::vector<u32> Waiting(PassCount, 0);
+    for(const graph_pass &Pass : graph->Passes) {
+        for(const graph_input &Input : Pass.Inputs) {
+            if(Pass.Used && Input.Pass != GRAPH_NO_PASS && !Input.Previous) {
+                ++Waiting[&Pass - graph->Passes.data()];
+            }
+        }
+    }
+
+    std::vector<b32> Done(PassCount, false);
+    graph->Order.clear();
+    for(b32 Progress = true; Progress;) {
+        Progress = false;
+        for(u32 PassIndex = 0; PassIndex < PassCount; ++PassIndex) {
+            if(Done[PassIndex] || !graph->Passes[PassIndex].Used || Waiting[PassIndex]) {
+                continue;
+            }
+            Done[PassIndex] = true;
+            Progress = true;
+            graph->Order.push_back(PassIndex);
+            for(u32 ReaderIndex = 0; ReaderIndex < PassCount; ++ReaderIndex) {
+                for(const graph_input &Input : graph->Passes[ReaderIndex].Inputs) {
+                    if(Input.Pass == (i32)PassIndex && !Input.Previous && graph->Passes[ReaderIndex].Used) {
+                        --Waiting[ReaderIndex];
+                    }
+                }
+            }
+            break;
+        }
+    }
+
+    std::string Stuck;
+    for(u32 PassIndex = 0; PassIndex < PassCount; ++PassIndex) {
+        if(graph->Passes[PassIndex].Used && !Done[PassIndex]) {
+            Stuck += (Stuck.empty() ? "" : ", ") + graph->Passes[PassIndex].Name;
+        }
+    }
+    if(!Stuck.empty()) {
+        std::cerr << "[Err] Graph: " << Stuck << " read each other within a frame, "
+                  << "mark one of the inputs \"previous\"" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// NOTE(Jovan): The image pass sets its channels on the frame loop's table, so
+// the handles are looked up against whichever table the pass is drawn with
+internal void
+GetGraphChannelUniforms(graph_pass *pass, uniform_table *table) {
+    for(u32 Channel = 0; Channel < GRAPH_MAX_INPUTS; ++Channel) {
+        pass->ChannelUniforms[Channel] = GetUniformHandle(table, "Channel" + std::to_string(Channel));
+    }
+    pass->ChannelResolution = GetUniformHandle(table, "ChannelResolution");
+}
+
+// NOTE(Jovan): Parses the file, sorts the passes and starts building their
+// shaders. The image pass isn't built here, its shader is the one the frame
+// loop draws anyway
+internal b32
+LoadRenderGraph(compile_queue *queue, shader_preprocessor *pp, render_graph *graph,
+                const std::string &path, const std::string &vertexPath) {
+    std::string Text;
+    graph->Path = path;
+    if(!ReadEntireFile(path, Text)) {
+        std::cerr << "[Err] Graph: Failed reading " << path << std::endl;
+        return false;
+    }
+    if(!ParseRenderGraph(graph, Text) || !ResolveGraphInputs(graph, &graph->Image)) {
+        return false;
+    }
+    for(graph_pass &Pass : graph->Passes) {
+        if(!ResolveGraphInputs(graph, &Pass)) {
+            return false;
+        }
+    }
+
+    MarkGraphPassUsed(graph, &graph->Image);
+    for(graph_pass &Pass : graph->Passes) {
+        if(!Pass.Used) {
+            std::cerr << "[Err] Graph: Nothing on screen depends on " << Pass.Name << ", skipping it" << std::endl;
+        }
+    }
+    if(!SortRenderGraph(graph)) {
+        return false;
+    }
+
+    for(u32 PassIndex : graph->Order) {
+        graph_pass *Pass = &graph->Passes[PassIndex];
+        Pass->Standard = GetStandardUniforms(&Pass->Uniforms);
+        GetGraphChannelUniforms(Pass, &Pass->Uniforms);
+        if(!LoadVariantSet(queue, pp, &Pass->Shader, vertexPath, Pass->FragmentPath, 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+internal void
+ReleaseGraphTargets(render_graph *graph) {
+    for(graph_target &Target : graph->Targets) {
+        glDeleteFramebuffers(1, &Target.Framebuffer);
+        glDeleteTextures(1, &Target.Texture);
+    }
+    graph->Targets.clear();
+}
+
+// NOTE(Jovan): A pass only takes over a target whose last reader came before
+// it, so nothing it reads can be sitting in the one it writes
+internal i32
+AcquireGraphTarget(render_graph *graph, graph_format format, i32 width, i32 height, i32 position, i32 busyUntil) {
+    for(u32 TargetIndex = 0; TargetIndex < graph->Targets.size(); ++TargetIndex) {
+        graph_target *Target = &graph->Targets[TargetIndex];
+        if(Target->Format == format && Target->Width == width && Target->Height == height &&
+           Target->BusyUntil < position) {
+            Target->BusyUntil = busyUntil;
+            return (i32)TargetIndex;
+        }
+    }
+
+    graph_target Target = {};
+    Target.Format = format;
+    Target.Width = width;
+    Target.Height = height;
+    Target.BusyUntil = busyUntil;
+    GLenum InternalFormat = format == GraphFormat_RGBA32F ? GL_RGBA32F : format == GraphFormat_RGBA16F ? GL_RGBA16F : GL_RGBA8;
+    glGenTextures(1, &Target.Texture);
+    glBindTexture(GL_TEXTURE_2D, Target.Texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, InternalFormat, width, height, 0, GL_RGBA,
+                 format == GraphFormat_RGBA8 ? GL_UNSIGNED_BYTE : GL_FLOAT, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glGenFramebuffers(1, &Target.Framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, Target.Framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Target.Texture, 0);
+    // NOTE(Jovan): Feedback reads these before anything was drawn into them
+    r32 Zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    glClearBufferfv(GL_COLOR, 0, Zero);
+    graph->Targets.push_back(Target);
+    return (i32)graph->Targets.size() - 1;
+}
+
+internal void
+PlanGraphTargets(render_graph *graph, i32 width, i32 height) {
+    ReleaseGraphTargets(graph);
+    graph->Width = width;
+    graph->Height = height;
+
+    i32 ImagePosition = (i32)graph->Order.size();
+    for(u32 PassIndex : graph->Order) {
+        graph->Passes[PassIndex].LastReader = -1;
+    }
+    for(i32 Position = 0; Position <= ImagePosition; ++Position) {
+        const graph_pass *Reader = Position < ImagePosition ? &graph->Passes[graph->Order[Position]] : &graph->Image;
+        for(const graph_input &Input : Reader->Inputs) {
+            if(Input.Pass != GRAPH_NO_PASS && !Input.Previous) {
+                graph->Passes[Input.Pass].LastReader = std::max(graph->Passes[Input.Pass].LastReader, Position);
+            }
+        }
+    }
+
+    u64 Requested = 0, Allocated = 0;
+    for(i32 Position = 0; Position < ImagePosition; ++Position) {
+        graph_pass *Pass = &graph->Passes[graph->Order[Position]];
+        Pass->Width = std::max(1, (i32)round(width * Pass->Scale));
+        Pass->Height = std::max(1, (i32)round(height * Pass->Scale));
+        Pass->Current = 0;
+        u64 Bytes = (u64)Pass->Width * Pass->Height * GraphFormatBytes(Pass->Format);
+        // NOTE(Jovan): A pass that isn't built yet doesn't draw, whoever it
+        // would hand its target to could leave something there its readers
+        // take for its result. It keeps one to itself until it's built
+        Pass->Private = !Pass->Persistent && !Pass->ProgramID;
+        if(Pass->Persistent) {
+            for(u32 Index = 0; Index < 2; ++Index) {
+                Pass->Targets[Index] = AcquireGraphTarget(graph, Pass->Format, Pass->Width, Pass->Height, Position, INT32_MAX);
+            }
+            Requested += 2 * Bytes;
+        } else {
+            Pass->Targets[0] = Pass->Targets[1] = AcquireGraphTarget(graph, Pass->Format, Pass->Width, Pass->Height,
+                                                                     Pass->Private ? INT32_MIN : Position,
+                                                                     Pass->Private ? INT32_MAX : Pass->LastReader);
+            Requested += Bytes;
+        }
+    }
+    for(const graph_target &Target : graph->Targets) {
+        Allocated += (u64)Target.Width * Target.Height * GraphFormatBytes(Target.Format);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    char Line[160];
+    snprintf(Line, sizeof(Line), "%u passes in %u textures, %.1f MB instead of %.1f MB",
+             (u32)graph->Order.size(), (u32)graph->Targets.size(), Allocated / (1024.0 * 1024.0),
+             Requested / (1024.0 * 1024.0));
+    std::cout << "[Info] Graph: " << Line << std::endl;
+}
+
+internal b32
+ReloadRenderGraph(compile_queue *queue, shader_preprocessor *pp, render_graph *graph,
+                  const std::vector<std::string> &changed) {
+    b32 Reloaded = false;
+    for(u32 PassIndex : graph->Order) {
+        u32 Key = 0;
+        Reloaded |= ReloadVariantSet(queue, pp, &graph->Passes[PassIndex].Shader, changed, &Key);
+    }
+    return Reloaded;
+}
+
+internal void
+UpdateRenderGraph(compile_queue *queue, render_graph *graph) {
+    for(u32 PassIndex : graph->Order) {
+        graph_pass *Pass = &graph->Passes[PassIndex];
+        UpdateVariantSet(queue, &Pass->Shader);
+        Pass->ProgramID = GetVariantProgram(queue, &Pass->Shader, 0);
+        if(Pass->ProgramID) {
+            ReflectProgramUniforms(&Pass->Uniforms, Pass->ProgramID);
+            if(Pass->Private) {
+                // NOTE(Jovan): Plan again so it can share like the rest
+                graph->Width = 0;
+            }
+        }
+    }
+}
+
+// NOTE(Jovan): Where the input of a channel is this frame, the pass has
+// already been drawn into its current target by then
+internal const graph_target*
+GraphInputTarget(const render_graph *graph, const graph_input *input) {
+    const graph_pass *Source = &graph->Passes[input->Pass];
+    return &graph->Targets[Source->Targets[input->Previous ? Source->Current ^ 1 : Source->Current]];
+}
+
+internal void
+SetGraphChannels(const render_graph *graph, const graph_pass *pass, uniform_table *table) {
+    r32 Sizes[GRAPH_MAX_INPUTS * 2] = {};
+    for(u32 Channel = 0; Channel < GRAPH_MAX_INPUTS; ++Channel) {
+        const graph_input *Input = &pass->Inputs[Channel];
+        SetUniform1i(table, pass->ChannelUniforms[Channel], (i32)Channel);
+        if(Input->Pass != GRAPH_NO_PASS) {
+            Sizes[Channel * 2] = (r32)graph->Passes[Input->Pass].Width;
+            Sizes[Channel * 2 + 1] = (r32)graph->Passes[Input->Pass].Height;
+        }
+    }
+    SetUniformData(table, pass->ChannelResolution, GL_FLOAT_VEC2, Sizes, sizeof(Sizes));
+}
+
+// NOTE(Jovan): The buffer passes' side of what the frame loop does for its
+// own shader, mouse comes in window pixels and gets scaled to each pass
+internal void
+SetRenderGraphInputs(render_graph *graph, i32 width, i32 height, r32 time, r32 mouseX, r32 mouseY,
+                     r32 left, r32 right) {
+    if(graph->Width != width || graph->Height != height) {
+        PlanGraphTargets(graph, width, height);
+    }
+    for(u32 PassIndex : graph->Order) {
+        graph_pass *Pass = &graph->Passes[PassIndex];
+        SetUniform2f(&Pass->Uniforms, Pass->Standard.Resolution, (r32)Pass->Width, (r32)Pass->Height);
+        SetUniform1f(&Pass->Uniforms, Pass->Standard.Time, time);
+        SetUniform4f(&Pass->Uniforms, Pass->Standard.Mouse, mouseX * Pass->Width / width,
+                     mouseY * Pass->Height / height, left, right);
+        SetGraphChannels(graph, Pass, &Pass->Uniforms);
+    }
+}
+
+// NOTE(Jovan): For the idle check, with no pass reading time or frame and no
+// feedback the targets hold still until one of the inputs changes
+internal b32
+RenderGraphAnimating(const render_graph *graph) {
+    for(u32 PassIndex : graph->Order) {
+        const graph_pass *Pass = &graph->Passes[PassIndex];
+        if(Pass->Persistent || UniformIsRead(&Pass->Uniforms, Pass->Standard.Time) ||
+           UniformIsRead(&Pass->Uniforms, Pass->Standard.Frame)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+internal b32
+RenderGraphChanged(const render_graph *graph) {
+    for(u32 PassIndex : graph->Order) {
+        if(ReadUniformsChanged(&graph->Passes[PassIndex].Uniforms)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+internal void
+BindGraphInputs(const render_graph *graph, const graph_pass *pass) {
+    for(u32 Channel = 0; Channel < GRAPH_MAX_INPUTS; ++Channel) {
+        const graph_input *Input = &pass->Inputs[Channel];
+        glActiveTexture(GL_TEXTURE0 + Channel);
+        glBindTexture(GL_TEXTURE_2D, Input->Pass != GRAPH_NO_PASS ? GraphInputTarget(graph, Input)->Texture : 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+// NOTE(Jovan): Draws every buffer pass in order and puts back whatever
+// framebuffers and viewport it was called with. Passes whose program isn't
+// built yet are skipped, their targets aren't shared so readers get the last
+// thing they drew or nothing
+internal void
+ExecuteRenderGraph(render_graph *graph, gpu_profiler *profiler, u32 frame, u32 vao) {
+    i32 DrawFramebuffer, ReadFramebuffer, Viewport[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &DrawFramebuffer);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &ReadFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, Viewport);
+
+    for(u32 PassIndex : graph->Order) {
+        graph_pass *Pass = &graph->Passes[PassIndex];
+        if(Pass->Persistent) {
+            Pass->Current ^= 1;
+        }
+    }
+
+    glBindVertexArray(vao);
+    for(u32 PassIndex : graph->Order) {
+        graph_pass *Pass = &graph->Passes[PassIndex];
+        if(!Pass->ProgramID) {
+            Pass->Current ^= Pass->Persistent;
+            continue;
+        }
+        BeginGpuPass(profiler, Pass->Name.c_str());
+        glBindFramebuffer(GL_FRAMEBUFFER, graph->Targets[Pass->Targets[Pass->Current]].Framebuffer);
+        glViewport(0, 0, Pass->Width, Pass->Height);
+        glUseProgram(Pass->ProgramID);
+        SetUniform1i(&Pass->Uniforms, Pass->Standard.Frame, (i32)frame);
+        UploadUniforms(&Pass->Uniforms);
+        BindGraphInputs(graph, Pass);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        EndGpuPass(profiler);
+    }
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, DrawFramebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, ReadFramebuffer);
+    glViewport(Viewport[0], Viewport[1], Viewport[2], Viewport[3]);
+}
+
+internal void
+ShutdownRenderGraph(compile_queue *queue, render_graph *graph) {
+    for(graph_pass &Pass : graph->Passes) {
+        DeleteVariantPrograms(queue, &Pass.Shader);
+    }
+    ReleaseGraphTargets(graph);
+}
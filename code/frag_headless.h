@@ -0,0 +1,423 @@
+// NOTE(Jovan): Headless rendering. No window and no swap chain, the shader
+// draws into an FBO on an EGL context for a fixed number of frames, time
+// advancing by a fixed step each frame regardless of how long it took. Works
+// on Mesa's surfaceless platform, which is what llvmpipe gives us on boxes
+// without a display or a GPU
+
+#define HEADLESS_BUILD_POLL_MS 1
+#define TILE_PROBE_SIZE 256
+#define TILE_MIN_SIZE 64
+#define TILE_DEFAULT_BUDGET_MS 50.0
+
+struct headless_options {
+    std::string VertexPath;
+    std::string FragmentPath;
+    i32 Width;
+    i32 Height;
+    u32 Frames;
+    r64 Timestep;
+    std::string OutputPath;
+    b32 ReadbackAll;
+    u32 ReadbackSlots;
+    b32 Tiled;
+    r64 TileBudgetMs;
+    b32 Profile;
+};
+
+struct headless_target {
+    u32 Framebuffer;
+    u32 Color;
+    u32 Depth;
+    i32 Width;
+    i32 Height;
+};
+
+internal b32
+ParseResolution(const std::string &text, i32 *width, i32 *height) {
+    char Separator = 0;
+    return sscanf(text.c_str(), "%d%c%d", width, &Separator, height) == 3 &&
+           (Separator == 'x' || Separator == 'X') && *width > 0 && *height > 0;
+}
+
+internal b32
+CreateHeadlessTarget(headless_target *target, i32 width, i32 height) {
+    i32 MaxSize = 0, MaxViewport[2] = {};
+    glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &MaxSize);
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, MaxViewport);
+    if(width > MaxSize || height > MaxSize || width > MaxViewport[0] || height > MaxViewport[1]) {
+        std::cerr << "[Err] Headless: " << width << "x" << height << " is over the driver's limit of "
+                  << std::min(MaxSize, std::min(MaxViewport[0], MaxViewport[1])) << std::endl;
+        return false;
+    }
+
+    target->Width = width;
+    target->Height = height;
+    glGenFramebuffers(1, &target->Framebuffer);
+    glGenRenderbuffers(1, &target->Color);
+    glGenRenderbuffers(1, &target->Depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, target->Color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, target->Depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, target->Framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target->Color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target->Depth);
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "[Err] Headless: Framebuffer incomplete at " << width << "x" << height << std::endl;
+        return false;
+    }
+    return true;
+}
+
+internal void
+DestroyHeadlessTarget(headless_target *target) {
+    glDeleteFramebuffers(1, &target->Framebuffer);
+    glDeleteRenderbuffers(1, &target->Color);
+    glDeleteRenderbuffers(1, &target->Depth);
+    *target = {};
+}
+
+struct headless_output {
+    std::string Path;
+    b32 Failed;
+};
+
+// NOTE(Jovan): Binary PPM, rows flipped since GL reads bottom up
+internal b32
+WriteFramePPM(const std::string &path, i32 width, i32 height, const u8 *rgba) {
+    std::ofstream Out(path, std::ios::out | std::ios::binary);
+    if(!Out) {
+        return false;
+    }
+
+    Out << "P6\n" << width << " " << height << "\n255\n";
+    std::vector<u8> Row((size_t)width * 3);
+    for(i32 Y = height - 1; Y >= 0; --Y) {
+        const u8 *At = rgba + (size_t)Y * width * 4;
+        for(i32 X = 0; X < width; ++X) {
+            Row[X * 3 + 0] = At[X * 4 + 0];
+            Row[X * 3 + 1] = At[X * 4 + 1];
+            Row[X * 3 + 2] = At[X * 4 + 2];
+        }
+        Out.write((const char*)Row.data(), (std::streamsize)Row.size());
+    }
+    return Out.good();
+}
+
+// NOTE(Jovan): Puts the frame number into an --output path. Takes %d or %u
+// with an optional width, zero padded with a leading 0, and %% for a percent
+// sign. Returns how many numbers went in, -1 for any other conversion
+internal i32
+ExpandFramePath(const std::string &pattern, u32 frame, std::string *out) {
+    out->clear();
+    i32 Numbers = 0;
+    for(size_t At = 0; At < pattern.size(); ++At) {
+        if(pattern[At] != '%') {
+            *out += pattern[At];
+            continue;
+        }
+        if(At + 1 < pattern.size() && pattern[At + 1] == '%') {
+            *out += '%';
+            ++At;
+            continue;
+        }
+
+        size_t End = At + 1;
+        b32 ZeroPad = End < pattern.size() && pattern[End] == '0';
+        u32 Width = 0;
+        while(End < pattern.size() && isdigit((u8)pattern[End]) && Width <= 32) {
+            Width = Width * 10 + (pattern[End++] - '0');
+        }
+        if(Width > 32 || End >= pattern.size() || (pattern[End] != 'd' && pattern[End] != 'u')) {
+            return -1;
+        }
+        std::string Number = std::to_string(frame);
+        if(Number.size() < Width) {
+            Number.insert(0, Width - Number.size(), ZeroPad ? '0' : ' ');
+        }
+        *out += Number;
+        ++Numbers;
+        At = End;
+    }
+    return Numbers;
+}
+
+// NOTE(Jovan): A path with a frame number in it gets one file per frame,
+// anything else is overwritten with the latest frame
+internal void
+_WriteHeadlessFrame(void *user, u32 frame, const u8 *rgba, i32 width, i32 height) {
+    headless_output *Output = (headless_output*)user;
+    if(Output->Path.empty()) {
+        return;
+    }
+
+    std::string Path;
+    ExpandFramePath(Output->Path, frame, &Path);
+    if(!WriteFramePPM(Path, width, height, rgba)) {
+        std::cerr << "[Err] Headless: Failed writing " << Path << std::endl;
+        Output->Failed = true;
+    }
+}
+
+// NOTE(Jovan): There's no frame loop to hide the build behind, so this just
+// keeps polling the queue until the first variant is in or has failed
+internal u32
+WaitForVariantProgram(compile_queue *queue, variant_set *set, u32 key) {
+    for(;;) {
+        UpdateCompileQueue(queue);
+        UpdateVariantSet(queue, set);
+        shader_program *Program = &set->Programs[key];
+        if(Program->ID || !Program->PendingBuild) {
+            return Program->ID;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(HEADLESS_BUILD_POLL_MS));
+    }
+}
+
+// NOTE(Jovan): One horizontal strip of the tiled image, tiles land in it as
+// their readbacks come in and it goes to the file once the strip is done
+struct tile_strip {
+    std::vector<u8> Rows;
+    std::vector<i32> TileX;
+    i32 Width;
+    i32 Top;
+    i32 Height;
+    i32 TileY;
+};
+
+internal void
+_CopyTileToStrip(void *user, u32 tile, const u8 *rgba, i32 width, i32 height) {
+    tile_strip *Strip = (tile_strip*)user;
+    i32 X0 = Strip->TileX[tile];
+    i32 Columns = std::min(width, Strip->Width - X0);
+    for(i32 Y = 0; Y < height; ++Y) {
+        i32 ImageY = Strip->TileY + Y;
+        if(ImageY < Strip->Top - Strip->Height || ImageY >= Strip->Top) {
+            continue;
+        }
+        u8 *Out = Strip->Rows.data() + ((size_t)(Strip->Top - 1 - ImageY) * Strip->Width + X0) * 3;
+        const u8 *In = rgba + (size_t)Y * width * 4;
+        for(i32 X = 0; X < Columns; ++X) {
+            Out[X * 3 + 0] = In[X * 4 + 0];
+            Out[X * 3 + 1] = In[X * 4 + 1];
+            Out[X * 3 + 2] = In[X * 4 + 2];
+        }
+    }
+}
+
+// NOTE(Jovan): Renders the image a strip at a time from the top, so the PPM
+// can be written front to back and only one strip is ever held in memory.
+// The shader sees the whole image through Resolution and FragOffset. The
+// first strip uses small probe tiles, after each strip the tile size is
+// picked so the slowest tile seen so far would take about the budget
+internal i32
+RenderTiled(const headless_options *options, u32 programID, uniform_table *uniforms,
+            const standard_uniforms *inputs) {
+    if(options->OutputPath.empty()) {
+        std::cerr << "[Err] Tiled: Needs an --output file to stream into" << std::endl;
+        return 1;
+    }
+    std::ofstream Out(options->OutputPath, std::ios::out | std::ios::binary);
+    if(!Out) {
+        std::cerr << "[Err] Tiled: Failed opening " << options->OutputPath << std::endl;
+        return 1;
+    }
+    Out << "P6\n" << options->Width << " " << options->Height << "\n255\n";
+
+    i32 MaxSize = 0, MaxViewport[2] = {};
+    glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &MaxSize);
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, MaxViewport);
+    MaxSize = std::min(MaxSize, std::min(MaxViewport[0], MaxViewport[1]));
+
+    u32 VAO;
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glUseProgram(programID);
+    ReflectProgramUniforms(uniforms, programID);
+    u32 Frame = options->Frames ? options->Frames - 1 : 0;
+    SetUniform2f(uniforms, inputs->Resolution, (r32)options->Width, (r32)options->Height);
+    SetUniform1f(uniforms, inputs->Time, (r32)(Frame * options->Timestep));
+    SetUniform1i(uniforms, inputs->Frame, (i32)Frame);
+    SetUniform4f(uniforms, inputs->Mouse, 0.0f, 0.0f, 0.0f, 0.0f);
+
+    i32 TileWidth = std::min(TILE_PROBE_SIZE, MaxSize);
+    i32 TileHeight = TileWidth;
+    r64 WorstMsPerPixel = 0.0;
+    r64 WorstTileMs = 0.0;
+    u32 TileCount = 0;
+    b32 Failed = false;
+    auto Start = std::chrono::steady_clock::now();
+    for(i32 Top = options->Height; Top > 0 && !Failed;) {
+        headless_target Target = {};
+        if(!CreateHeadlessTarget(&Target, TileWidth, TileHeight)) {
+            Failed = true;
+            break;
+        }
+        glViewport(0, 0, TileWidth, TileHeight);
+
+        tile_strip Strip;
+        Strip.Width = options->Width;
+        Strip.Top = Top;
+        Strip.Height = std::min(TileHeight, Top);
+        Strip.TileY = Top - TileHeight;
+        Strip.Rows.resize((size_t)Strip.Width * Strip.Height * 3);
+        frame_readback Readback = {};
+        InitFrameReadback(&Readback, options->ReadbackSlots, TileWidth, TileHeight, _CopyTileToStrip, &Strip);
+
+        for(i32 X0 = 0; X0 < options->Width; X0 += TileWidth) {
+            SetUniform2f(uniforms, inputs->FragOffset, (r32)X0, (r32)Strip.TileY);
+            UploadUniforms(uniforms);
+            // NOTE(Jovan): Finishing every tile keeps at most one queued, which
+            // is what keeps the watchdog quiet. It's timed on the CPU since
+            // software rasterizers only do the work once they're flushed
+            auto TileStart = std::chrono::steady_clock::now();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glFinish();
+            r64 TileMs = MillisecondsSince(TileStart);
+            Strip.TileX.push_back(X0);
+            QueueFrameReadback(&Readback, (u32)Strip.TileX.size() - 1);
+            WorstTileMs = std::max(WorstTileMs, TileMs);
+            WorstMsPerPixel = std::max(WorstMsPerPixel, TileMs / ((r64)TileWidth * TileHeight));
+            ++TileCount;
+        }
+        FlushFrameReadback(&Readback);
+        ShutdownFrameReadback(&Readback);
+        DestroyHeadlessTarget(&Target);
+
+        Out.write((const char*)Strip.Rows.data(), (std::streamsize)Strip.Rows.size());
+        if(!Out) {
+            std::cerr << "[Err] Tiled: Failed writing " << options->OutputPath << std::endl;
+            Failed = true;
+        }
+        Top -= Strip.Height;
+
+        r64 Pixels = WorstMsPerPixel > 0.0 ? options->TileBudgetMs / WorstMsPerPixel : (r64)MaxSize * MaxSize;
+        i32 Side = (i32)sqrt(std::max(Pixels, (r64)TILE_MIN_SIZE * TILE_MIN_SIZE));
+        TileWidth = std::max(TILE_MIN_SIZE, std::min(std::min(Side, MaxSize), options->Width));
+        TileHeight = std::max(TILE_MIN_SIZE, std::min((i32)std::min(Pixels / TileWidth, (r64)MaxSize), Top));
+    }
+
+    glDeleteVertexArrays(1, &VAO);
+    if(Failed) {
+        return 1;
+    }
+
+    char Line[160];
+    snprintf(Line, sizeof(Line), "%dx%d in %u tiles, %.1f ms, slowest tile %.2f ms", options->Width,
+             options->Height, TileCount, MillisecondsSince(Start), WorstTileMs);
+    std::cout << "[Info] Tiled: " << Line << std::endl;
+    return 0;
+}
+
+internal i32
+RenderHeadless(const headless_options *options) {
+    egl_device Device;
+    egl_context Context;
+    if(!InitHeadlessDevice(&Device)) {
+        return 1;
+    }
+    if(!CreateHeadlessContext(&Device, &Context) || !MakeHeadlessContextCurrent(&Device, &Context) ||
+       !gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cerr << "[Err] Headless: Failed setting up a context" << std::endl;
+        DestroyHeadlessContext(&Device, &Context);
+        ShutdownHeadlessDevice(&Device);
+        return 1;
+    }
+    std::cout << "[Info] Headless: " << glGetString(GL_RENDERER) << std::endl;
+
+    InitProgramCache(&G_PROGRAM_CACHE, DefaultProgramCacheDir());
+    compile_queue CompileQueue;
+    InitCompileQueue(&CompileQueue);
+    shader_preprocessor Preprocessor;
+    Preprocessor.IncludeDirs.push_back("../shaders/include");
+    variant_set Shader = {};
+
+    i32 Result = 1;
+    headless_target Target = {};
+    u32 ProgramID = 0;
+    if(LoadVariantSet(&CompileQueue, &Preprocessor, &Shader, options->VertexPath, options->FragmentPath, 0)) {
+        ProgramID = WaitForVariantProgram(&CompileQueue, &Shader, 0);
+    }
+    if(ProgramID && options->Tiled) {
+        uniform_table Uniforms = {};
+        standard_uniforms Inputs = GetStandardUniforms(&Uniforms);
+        Result = RenderTiled(options, ProgramID, &Uniforms, &Inputs);
+    } else if(ProgramID && CreateHeadlessTarget(&Target, options->Width, options->Height)) {
+        uniform_table Uniforms = {};
+        standard_uniforms Inputs = GetStandardUniforms(&Uniforms);
+        gpu_profiler Profiler = {};
+        Profiler.Enabled = options->Profile;
+        InitGpuProfiler(&Profiler);
+
+        u32 VAO;
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+        glBindFramebuffer(GL_FRAMEBUFFER, Target.Framebuffer);
+        glViewport(0, 0, Target.Width, Target.Height);
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glUseProgram(ProgramID);
+        ReflectProgramUniforms(&Uniforms, ProgramID);
+        SetUniform2f(&Uniforms, Inputs.Resolution, (r32)Target.Width, (r32)Target.Height);
+        SetUniform4f(&Uniforms, Inputs.Mouse, 0.0f, 0.0f, 0.0f, 0.0f);
+
+        headless_output Output = {options->OutputPath, false};
+        std::string FirstPath;
+        b32 EveryFrame = options->ReadbackAll || ExpandFramePath(options->OutputPath, 0, &FirstPath) > 0;
+        frame_readback Readback = {};
+        InitFrameReadback(&Readback, options->ReadbackSlots, Target.Width, Target.Height, _WriteHeadlessFrame, &Output);
+
+        auto Start = std::chrono::steady_clock::now();
+        for(u32 FrameIndex = 0; FrameIndex < options->Frames; ++FrameIndex) {
+            SetUniform1f(&Uniforms, Inputs.Time, (r32)(FrameIndex * options->Timestep));
+            SetUniform1i(&Uniforms, Inputs.Frame, (i32)FrameIndex);
+            UploadUniforms(&Uniforms);
+
+            BeginProfilerFrame(&Profiler);
+            BeginGpuPass(&Profiler, "Shader");
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            EndGpuPass(&Profiler);
+            EndProfilerFrame(&Profiler);
+            if(EveryFrame || (!options->OutputPath.empty() && FrameIndex + 1 == options->Frames)) {
+                QueueFrameReadback(&Readback, FrameIndex);
+            }
+            // NOTE(Jovan): Nothing swaps, so nothing else would push the
+            // frame to the driver
+            glFlush();
+        }
+        FlushFrameReadback(&Readback);
+        glFinish();
+        r64 Milliseconds = MillisecondsSince(Start);
+        char Line[128];
+        snprintf(Line, sizeof(Line), "%u frames at %dx%d in %.1f ms, %.3f ms per frame", options->Frames,
+                 Target.Width, Target.Height, Milliseconds, Milliseconds / std::max(options->Frames, 1u));
+        std::cout << "[Info] Headless: " << Line << std::endl;
+        if(Profiler.Enabled) {
+            PrintGpuProfile(&Profiler);
+        }
+        if(Readback.Reads) {
+            PrintReadbackStats(&Readback);
+        }
+        Result = Output.Failed ? 1 : 0;
+
+        ShutdownFrameReadback(&Readback);
+        glDeleteVertexArrays(1, &VAO);
+        ShutdownGpuProfiler(&Profiler);
+    } else if(!ProgramID) {
+        std::cerr << "[Err] Headless: No program to render " << options->FragmentPath << " with" << std::endl;
+    }
+
+    DestroyHeadlessTarget(&Target);
+    ShutdownCompileQueue(&CompileQueue);
+    DeleteVariantPrograms(&CompileQueue, &Shader);
+    ShutdownLibraryCache();
+    DestroyHeadlessContext(&Device, &Context);
+    ShutdownHeadlessDevice(&Device);
+    return Result;
+}
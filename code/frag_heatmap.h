@@ -0,0 +1,415 @@
+// NOTE(Jovan): Cost heatmap. A copy of the fragment shader gets rewritten to
+// count loop iterations and texture samples per pixel and to write those
+// counts instead of its color. They go into a float target that is drawn
+// in false color with a legend along the bottom edge, per region numbers
+// get printed every so often. Those come back through a pixel buffer a few
+// frames later, the frame loop never waits on them
+
+#define HEATMAP_TEXTURE_WEIGHT 4.0f
+#define HEATMAP_REGIONS_X 4
+#define HEATMAP_REGIONS_Y 4
+#define HEATMAP_STATS_FRAMES 60
+#define HEATMAP_LEGEND_HEIGHT 20
+
+global const char *HEATMAP_FRAGMENT_SOURCE = R"(#version 330 core
+uniform sampler2D Heat;
+uniform float HeatMax;
+uniform float TextureWeight;
+uniform vec2 Regions;
+uniform float LegendHeight;
+out vec4 FragColor;
+
+vec3 HeatColor(float T) {
+    T = clamp(T, 0.0, 1.0);
+    return clamp(vec3(1.5) - abs(4.0 * T - vec3(3.0, 2.0, 1.0)), 0.0, 1.0);
+}
+
+void main() {
+    vec2 Size = vec2(textureSize(Heat, 0));
+    vec2 P = gl_FragCoord.xy;
+    if(P.y < LegendHeight) {
+        // NOTE(Jovan): Ticks at every quarter of HeatMax
+        float T = P.x / Size.x;
+        float Tick = abs(fract(T * 4.0 + 0.5) - 0.5) * Size.x * 0.25;
+        FragColor = vec4(Tick < 1.0 && P.y < LegendHeight * 0.4 ? vec3(1.0) : HeatColor(T), 1.0);
+        return;
+    }
+
+    vec2 Counts = texelFetch(Heat, ivec2(P), 0).rg;
+    float Cost = Counts.r + TextureWeight * Counts.g;
+    vec3 Color = Cost > 0.0 ? HeatColor(Cost / HeatMax) : vec3(0.0);
+    vec2 Cell = mod(P, Size / Regions);
+    if(Cell.x < 1.0 || Cell.y < 1.0) {
+        Color = mix(Color, vec3(1.0), 0.35);
+    }
+    FragColor = vec4(Color, 1.0);
+}
+)";
+
+struct heatmap_view {
+    b32 Enabled;
+    b32 Failed;
+    u32 SourceID;
+    shader_program Program;
+    u32 ViewProgram;
+    i32 HeatMaxLocation;
+    u32 Framebuffer;
+    u32 Texture;
+    i32 Width;
+    i32 Height;
+    r32 HeatMax;
+    u32 Frame;
+    frame_readback Readback;
+};
+
+internal b32
+IsTextureFunction(const std::string &name) {
+    const char *Names[] = {"texture", "textureLod", "textureGrad", "textureOffset", "textureLodOffset",
+                           "textureGradOffset", "textureProj", "textureProjLod", "textureProjGrad",
+                           "textureProjOffset", "textureGather", "textureGatherOffset", "texelFetch",
+                           "texelFetchOffset", "texture2D", "texture2DLod", "textureCube"};
+    for(const char *Name : Names) {
+        if(name == Name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+internal b32
+StartsDirective(const std::string &text, size_t at) {
+    if(text[at] != '#') {
+        return false;
+    }
+    while(at > 0 && (text[at - 1] == ' ' || text[at - 1] == '\t')) --at;
+    return at == 0 || text[at - 1] == '\n';
+}
+
+// NOTE(Jovan): Skips comments and preprocessor lines, returns the position
+// of the next character that is actual code
+internal size_t
+SkipNonCode(const std::string &text, size_t at, size_t end) {
+    while(at < end) {
+        if(text.compare(at, 2, "//") == 0 || StartsDirective(text, at)) {
+            size_t Close = text.find('\n', at);
+            at = Close == std::string::npos || Close > end ? end : Close;
+        } else if(text.compare(at, 2, "/*") == 0) {
+            size_t Close = text.find("*/", at + 2);
+            at = Close == std::string::npos || Close + 2 > end ? end : Close + 2;
+        } else {
+            break;
+        }
+    }
+    return at;
+}
+
+internal size_t
+MatchingParen(const std::string &text, size_t open, size_t end) {
+    i32 Depth = 0;
+    for(size_t At = open; At < end;) {
+        size_t Code = SkipNonCode(text, At, end);
+        if(Code != At) {
+            At = Code;
+            continue;
+        }
+        if(text[At] == '(') ++Depth;
+        if(text[At] == ')' && --Depth == 0) return At;
+        ++At;
+    }
+    return std::string::npos;
+}
+
+// NOTE(Jovan): Loop conditions bump the iteration count, which makes it
+// iterations + 1 per loop but works whether the body has braces or not.
+// Texture calls get wrapped in a comma expression that bumps the sample count
+internal b32
+InstrumentHeat(const std::string &text, size_t at, size_t end, std::string &out) {
+    while(at < end) {
+        size_t Code = SkipNonCode(text, at, end);
+        out.append(text, at, Code - at);
+        at = Code;
+        if(at >= end) {
+            break;
+        }
+
+        if(!IsIdentifierChar(text[at]) || (at > 0 && IsIdentifierChar(text[at - 1]))) {
+            out += text[at++];
+            continue;
+        }
+
+        size_t WordEnd = at;
+        while(WordEnd < end && IsIdentifierChar(text[WordEnd])) ++WordEnd;
+        std::string Word = text.substr(at, WordEnd - at);
+        size_t Open = WordEnd;
+        while(Open < end && isspace((u8)text[Open])) ++Open;
+        b32 Instrumented = Word == "for" || Word == "while" || IsTextureFunction(Word);
+        if(!Instrumented || Open >= end || text[Open] != '(') {
+            out += Word;
+            at = WordEnd;
+            continue;
+        }
+
+        size_t Close = MatchingParen(text, Open, end);
+        if(Close == std::string::npos) {
+            return false;
+        }
+
+        if(Word == "for") {
+            size_t Semicolons[2];
+            u32 Found = 0;
+            i32 Depth = 0;
+            for(size_t Cursor = Open + 1; Cursor < Close && Found < 2; ++Cursor) {
+                Depth += text[Cursor] == '(';
+                Depth -= text[Cursor] == ')';
+                if(text[Cursor] == ';' && Depth == 0) Semicolons[Found++] = Cursor;
+            }
+            if(Found != 2) {
+                return false;
+            }
+
+            b32 EmptyCondition = true;
+            for(size_t Cursor = Semicolons[0] + 1; Cursor < Semicolons[1]; ++Cursor) {
+                EmptyCondition &= isspace((u8)text[Cursor]) != 0;
+            }
+            out += "for(";
+            if(!InstrumentHeat(text, Open + 1, Semicolons[0], out)) return false;
+            out += "; (_FragHeat.x += 1.0, ";
+            if(EmptyCondition) {
+                out += "true";
+            } else if(!InstrumentHeat(text, Semicolons[0] + 1, Semicolons[1], out)) {
+                return false;
+            }
+            out += ");";
+            if(!InstrumentHeat(text, Semicolons[1] + 1, Close, out)) return false;
+            out += ")";
+        } else if(Word == "while") {
+            out += "while((_FragHeat.x += 1.0, ";
+            if(!InstrumentHeat(text, Open + 1, Close, out)) return false;
+            out += "))";
+        } else {
+            out += "(_FragHeat.y += 1.0, " + Word + "(";
+            if(!InstrumentHeat(text, Open + 1, Close, out)) return false;
+            out += "))";
+        }
+        at = Close + 1;
+    }
+    return true;
+}
+
+// NOTE(Jovan): The first "out vec4" at the top level is where the counts go
+internal std::string
+FindColorOutput(const std::string &text) {
+    i32 Depth = 0;
+    for(size_t At = 0; At < text.size();) {
+        size_t Code = SkipNonCode(text, At, text.size());
+        if(Code != At) {
+            At = Code;
+            continue;
+        }
+        Depth += text[At] == '{';
+        Depth -= text[At] == '}';
+        if(Depth == 0 && text.compare(At, 3, "out") == 0 && (At == 0 || !IsIdentifierChar(text[At - 1])) &&
+           At + 3 < text.size() && isspace((u8)text[At + 3])) {
+            size_t Semicolon = text.find(';', At);
+            std::vector<std::string> Words = SplitWords(text.c_str() + At, text.c_str() + (Semicolon == std::string::npos ? At : Semicolon));
+            if(Words.size() == 3 && Words[1] == "vec4") {
+                return Words[2];
+            }
+        }
+        ++At;
+    }
+    return "";
+}
+
+internal b32
+InstrumentHeatSource(preprocessed_source *source, const std::string &path) {
+    std::string Text = InlineLinkedLibraries(source);
+    std::string Output = FindColorOutput(Text);
+    std::string Instrumented;
+    if(Output.empty()) {
+        std::cerr << "[Err] Heatmap: " << path << " has no \"out vec4\" to write the counts to" << std::endl;
+        return false;
+    }
+    if(!InstrumentHeat(Text, source->VersionEnd, Text.size(), Instrumented)) {
+        std::cerr << "[Err] Heatmap: Couldn't make sense of the loops in " << path << std::endl;
+        return false;
+    }
+
+    size_t Main = std::string::npos;
+    for(size_t At = Instrumented.find("main"); At != std::string::npos; At = Instrumented.find("main", At + 4)) {
+        size_t Open = Instrumented.find_first_not_of(" \t\r\n", At + 4);
+        if((At == 0 || !IsIdentifierChar(Instrumented[At - 1])) && Open != std::string::npos && Instrumented[Open] == '(') {
+            Main = At;
+        }
+    }
+    if(Main == std::string::npos) {
+        std::cerr << "[Err] Heatmap: " << path << " has no main" << std::endl;
+        return false;
+    }
+    Instrumented.replace(Main, 4, "_FragHeatMain");
+
+    source->Text = Text.substr(0, source->VersionEnd) + "vec2 _FragHeat = vec2(0.0);\n#line " +
+                   std::to_string(source->VersionLine + 1) + " 0\n" + Instrumented +
+                   "\nvoid main() {\n    _FragHeatMain();\n    " + Output + " = vec4(_FragHeat, 0.0, 1.0);\n}\n";
+    source->Links.clear();
+    source->Spirv.clear();
+    return true;
+}
+
+internal void
+InitHeatmap(heatmap_view *heat) {
+    heat->ViewProgram = BuildFullscreenProgram(HEATMAP_FRAGMENT_SOURCE, "heatmap");
+    if(heat->ViewProgram) {
+        // NOTE(Jovan): Only the top of the scale changes from frame to frame
+        glUseProgram(heat->ViewProgram);
+        glUniform1i(glGetUniformLocation(heat->ViewProgram, "Heat"), 0);
+        glUniform1f(glGetUniformLocation(heat->ViewProgram, "TextureWeight"), HEATMAP_TEXTURE_WEIGHT);
+        glUniform2f(glGetUniformLocation(heat->ViewProgram, "Regions"), HEATMAP_REGIONS_X, HEATMAP_REGIONS_Y);
+        glUniform1f(glGetUniformLocation(heat->ViewProgram, "LegendHeight"), HEATMAP_LEGEND_HEIGHT);
+        heat->HeatMaxLocation = glGetUniformLocation(heat->ViewProgram, "HeatMax");
+    }
+
+    glGenTextures(1, &heat->Texture);
+    glGenFramebuffers(1, &heat->Framebuffer);
+    heat->HeatMax = 64.0f;
+}
+
+internal void
+DropHeatmapProgram(compile_queue *queue, heatmap_view *heat) {
+    if(heat->Program.PendingBuild) {
+        CancelCompileJob(queue, heat->Program.PendingBuild);
+        heat->Program.PendingBuild = 0;
+    }
+    DeleteShaderProgram(&heat->Program);
+    heat->Failed = false;
+}
+
+// NOTE(Jovan): Returns the instrumented program once it is built, 0 while
+// the normal program should keep drawing
+internal u32
+UpdateHeatmap(compile_queue *queue, heatmap_view *heat, const shader_program *source) {
+    if(!heat->Enabled || source->ID != heat->SourceID) {
+        DropHeatmapProgram(queue, heat);
+        heat->SourceID = heat->Enabled ? source->ID : 0;
+        if(heat->SourceID) {
+            heat->Program = {};
+            heat->Program.VertexPath = source->VertexPath;
+            heat->Program.FragmentPath = source->FragmentPath;
+            heat->Program.Vertex = source->Vertex;
+            heat->Program.Fragment = source->Fragment;
+            if(InstrumentHeatSource(&heat->Program.Fragment, source->FragmentPath)) {
+                RequestProgramBuild(queue, &heat->Program);
+            } else {
+                heat->Failed = true;
+            }
+        }
+    }
+
+    UpdateProgramBuild(queue, &heat->Program);
+    return heat->Program.ID;
+}
+
+// NOTE(Jovan): Region rows are printed top to bottom, the same way they
+// show up on screen. The rows under the legend can't be seen and are left
+// out. The busiest pixel becomes the top of the color scale
+internal void
+_PrintHeatmapStats(void *user, u32, const u8 *pixels, i32 width, i32 height) {
+    heatmap_view *Heat = (heatmap_view*)user;
+    const r32 *Counts = (const r32*)pixels;
+
+    r64 Sums[HEATMAP_REGIONS_Y][HEATMAP_REGIONS_X] = {};
+    i32 RegionPixels[HEATMAP_REGIONS_Y][HEATMAP_REGIONS_X] = {};
+    r32 Max = 0.0f, MaxLoops = 0.0f, MaxSamples = 0.0f;
+    r64 Total = 0.0;
+    i32 Pixels = 0;
+    for(i32 Y = std::min(HEATMAP_LEGEND_HEIGHT, height - 1); Y < height; ++Y) {
+        for(i32 X = 0; X < width; ++X) {
+            const r32 *Pixel = &Counts[((size_t)Y * width + X) * 2];
+            r32 Cost = Pixel[0] + HEATMAP_TEXTURE_WEIGHT * Pixel[1];
+            i32 RegionX = X * HEATMAP_REGIONS_X / width;
+            i32 RegionY = (height - 1 - Y) * HEATMAP_REGIONS_Y / height;
+            Sums[RegionY][RegionX] += Cost;
+            ++RegionPixels[RegionY][RegionX];
+            Total += Cost;
+            ++Pixels;
+            if(Cost > Max) {
+                Max = Cost;
+                MaxLoops = Pixel[0];
+                MaxSamples = Pixel[1];
+            }
+        }
+    }
+
+    Heat->HeatMax = std::max(Max, 1.0f);
+    std::cout << "[Info] Heatmap: Mean " << Total / std::max(Pixels, 1) << ", max " << Max << " (" << MaxLoops
+              << " loop iterations, " << MaxSamples << " samples), texture samples count x"
+              << HEATMAP_TEXTURE_WEIGHT << std::endl;
+    for(i32 RegionY = 0; RegionY < HEATMAP_REGIONS_Y; ++RegionY) {
+        char Row[256];
+        i32 Length = 0;
+        for(i32 RegionX = 0; RegionX < HEATMAP_REGIONS_X; ++RegionX) {
+            if(RegionPixels[RegionY][RegionX]) {
+                Length += snprintf(Row + Length, sizeof(Row) - Length, " %9.1f",
+                                   Sums[RegionY][RegionX] / RegionPixels[RegionY][RegionX]);
+            } else {
+                Length += snprintf(Row + Length, sizeof(Row) - Length, " %9s", "-");
+            }
+        }
+        std::cout << "[Info] Heatmap:" << Row << std::endl;
+    }
+}
+
+internal void
+BeginHeatmapFrame(heatmap_view *heat, i32 width, i32 height) {
+    if(heat->Width != width || heat->Height != height) {
+        heat->Width = width;
+        heat->Height = height;
+        glBindTexture(GL_TEXTURE_2D, heat->Texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, width, height, 0, GL_RG, GL_FLOAT, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, heat->Framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, heat->Texture, 0);
+        if(heat->Readback.SlotCount) {
+            ShutdownFrameReadback(&heat->Readback);
+        }
+        InitFrameReadback(&heat->Readback, 1, width, height, _PrintHeatmapStats, heat, GL_RG, GL_FLOAT);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, heat->Framebuffer);
+}
+
+// NOTE(Jovan): Expects the instrumented program to have drawn into the heat
+// target, shows it on the default framebuffer
+internal void
+EndHeatmapFrame(heatmap_view *heat, u32 vao) {
+    // NOTE(Jovan): One readback at a time, the next one isn't started until
+    // the last came back
+    DeliverOldestReadback(&heat->Readback, false);
+    if(heat->Frame++ % HEATMAP_STATS_FRAMES == 0 && !heat->Readback.PendingCount) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, heat->Framebuffer);
+        QueueFrameReadback(&heat->Readback, heat->Frame);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    if(!heat->ViewProgram) {
+        return;
+    }
+    glUseProgram(heat->ViewProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, heat->Texture);
+    glUniform1f(heat->HeatMaxLocation, heat->HeatMax);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+internal void
+ShutdownHeatmap(compile_queue *queue, heatmap_view *heat) {
+    DropHeatmapProgram(queue, heat);
+    if(heat->ViewProgram) glDeleteProgram(heat->ViewProgram);
+    if(heat->Readback.SlotCount) {
+        ShutdownFrameReadback(&heat->Readback);
+    }
+    glDeleteFramebuffers(1, &heat->Framebuffer);
+    glDeleteTextures(1, &heat->Texture);
+}
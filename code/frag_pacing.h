@@ -0,0 +1,162 @@
+// NOTE(Jovan): Frame pacing. Vsync and adaptive vsync leave the waiting to
+// the driver, uncapped doesn't wait at all and fixed holds a target rate on
+// its own. The fixed wait sleeps for most of the frame and spins through the
+// last bit, the sleep is cheap but the scheduler routinely wakes us late, so
+// how late it tends to be decides where the spin starts
+
+#define PACING_REPORT_SECONDS 1.0
+#define PACING_MIN_SLACK_MS 0.25
+#define PACING_MAX_SLACK_MS 4.0
+
+enum pacing_mode {
+    Pacing_Vsync,
+    Pacing_Adaptive,
+    Pacing_Uncapped,
+    Pacing_Fixed,
+};
+
+struct frame_pacer {
+    pacing_mode Mode;
+    r64 TargetFPS;
+    r64 FrameMs;
+    r64 SlackMs;
+    b32 Started;
+    std::chrono::steady_clock::time_point Deadline;
+    std::chrono::steady_clock::time_point ReportStart;
+    u32 Frames;
+    u32 Missed;
+    r64 WorstMissMs;
+};
+
+internal b32
+ParsePacingMode(const std::string &name, pacing_mode *out) {
+    if(name == "vsync") {
+        *out = Pacing_Vsync;
+    } else if(name == "adaptive") {
+        *out = Pacing_Adaptive;
+    } else if(name == "uncapped") {
+        *out = Pacing_Uncapped;
+    } else if(name == "fixed") {
+        *out = Pacing_Fixed;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// NOTE(Jovan): Needs the window's context current. Adaptive only tears when a
+// frame came in late, drivers without swap_control_tear get plain vsync
+internal void
+InitFramePacer(frame_pacer *pacer, pacing_mode mode, r64 targetFPS) {
+    if(mode == Pacing_Adaptive && !glfwExtensionSupported("GLX_EXT_swap_control_tear") &&
+       !glfwExtensionSupported("WGL_EXT_swap_control_tear")) {
+        std::cerr << "[Err] Pacing: No swap_control_tear, using vsync instead of adaptive" << std::endl;
+        mode = Pacing_Vsync;
+    }
+    if(mode == Pacing_Fixed && targetFPS <= 0.0) {
+        std::cerr << "[Err] Pacing: Fixed pacing needs a positive rate, using vsync" << std::endl;
+        mode = Pacing_Vsync;
+    }
+
+    pacer->Mode = mode;
+    pacer->TargetFPS = targetFPS;
+    pacer->FrameMs = mode == Pacing_Fixed ? 1000.0 / targetFPS : 0.0;
+    pacer->SlackMs = 1.0;
+    pacer->Started = false;
+    pacer->Frames = 0;
+    pacer->Missed = 0;
+    pacer->WorstMissMs = 0.0;
+
+    switch(mode) {
+        case Pacing_Vsync: {
+            glfwSwapInterval(1);
+            std::cout << "[Info] Pacing: Vsync" << std::endl;
+        } break;
+        case Pacing_Adaptive: {
+            glfwSwapInterval(-1);
+            std::cout << "[Info] Pacing: Adaptive vsync" << std::endl;
+        } break;
+        case Pacing_Uncapped: {
+            glfwSwapInterval(0);
+            std::cout << "[Info] Pacing: Uncapped" << std::endl;
+        } break;
+        case Pacing_Fixed: {
+            glfwSwapInterval(0);
+            std::cout << "[Info] Pacing: Fixed " << targetFPS << " fps" << std::endl;
+        } break;
+    }
+}
+
+internal void
+ReportFramePacing(frame_pacer *pacer, std::chrono::steady_clock::time_point now) {
+    ++pacer->Frames;
+    r64 Elapsed = std::chrono::duration<r64>(now - pacer->ReportStart).count();
+    if(Elapsed < PACING_REPORT_SECONDS) {
+        return;
+    }
+
+    if(pacer->Missed) {
+        char Line[128];
+        snprintf(Line, sizeof(Line), "Missed %u of %u deadlines at %.1f fps, worst by %.2f ms",
+                 pacer->Missed, pacer->Frames, pacer->TargetFPS, pacer->WorstMissMs);
+        std::cerr << "[Err] Pacing: " << Line << std::endl;
+    }
+    pacer->ReportStart = now;
+    pacer->Frames = 0;
+    pacer->Missed = 0;
+    pacer->WorstMissMs = 0.0;
+}
+
+// NOTE(Jovan): After the loop sat idle the old deadline means nothing, the
+// next frame starts a fresh schedule and isn't counted as missed
+internal void
+RestartFramePacing(frame_pacer *pacer) {
+    pacer->Started = false;
+    pacer->Frames = 0;
+    pacer->Missed = 0;
+    pacer->WorstMissMs = 0.0;
+}
+
+// NOTE(Jovan): Call right before swapping. Returns once the frame's deadline
+// has come, a frame that's already late is counted and the schedule restarts
+// from it instead of rushing the following frames to catch up
+internal void
+WaitForFrameDeadline(frame_pacer *pacer) {
+    if(pacer->Mode != Pacing_Fixed) {
+        return;
+    }
+
+    auto Now = std::chrono::steady_clock::now();
+    if(!pacer->Started) {
+        // NOTE(Jovan): Loading doesn't count against the first frame
+        pacer->Started = true;
+        pacer->Deadline = Now;
+        pacer->ReportStart = Now;
+        return;
+    }
+
+    pacer->Deadline += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<r64, std::milli>(pacer->FrameMs));
+    if(Now > pacer->Deadline) {
+        r64 LateMs = std::chrono::duration<r64, std::milli>(Now - pacer->Deadline).count();
+        ++pacer->Missed;
+        pacer->WorstMissMs = std::max(pacer->WorstMissMs, LateMs);
+        pacer->Deadline = Now;
+        ReportFramePacing(pacer, Now);
+        return;
+    }
+
+    auto SleepUntil = pacer->Deadline - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<r64, std::milli>(pacer->SlackMs));
+    if(Now < SleepUntil) {
+        std::this_thread::sleep_until(SleepUntil);
+        // NOTE(Jovan): The slack follows the worst recent oversleep and
+        // shrinks back slowly once the scheduler calms down
+        r64 OversleepMs = std::chrono::duration<r64, std::milli>(std::chrono::steady_clock::now() - SleepUntil).count();
+        pacer->SlackMs = std::max(pacer->SlackMs * 0.99, OversleepMs * 1.25);
+        pacer->SlackMs = std::min(std::max(pacer->SlackMs, PACING_MIN_SLACK_MS), PACING_MAX_SLACK_MS);
+    }
+    while(std::chrono::steady_clock::now() < pacer->Deadline) {
+    }
+    ReportFramePacing(pacer, pacer->Deadline);
+}
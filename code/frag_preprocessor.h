@@ -0,0 +1,551 @@
+// NOTE(Jovan): GLSL #include preprocessor. Every file is scanned once for the
+// handful of directives we care about, the rest of the text is never looked
+// at again and gets copied over in chunks. Includes form a file level
+// dependency graph so a change to a library only rebuilds its users.
+// "#pragma link" pulls in a library the same way but only leaves its function
+// prototypes behind, the library itself is compiled once as its own object
+
+enum directive_kind {
+    Directive_Include,
+    Directive_Version,
+    Directive_PragmaOnce,
+    Directive_Variant,
+    Directive_Link,
+};
+
+struct source_directive {
+    directive_kind Kind;
+    size_t Begin;
+    size_t End;
+    u32 Line;
+    std::string Path;
+    std::vector<std::string> Args;
+};
+
+struct source_file {
+    std::string Path;
+    std::string Contents;
+    std::vector<source_directive> Directives;
+    std::vector<std::string> Includes;
+    b32 Missing;
+};
+
+struct variant_axis {
+    std::string Name;
+    std::vector<std::string> Values;
+    u32 Shift;
+    u32 Bits;
+};
+
+struct linked_library {
+    std::string Path;
+    std::string Text;
+    std::vector<std::string> Files;
+};
+
+struct source_knob {
+    std::string Name;
+    std::string Value;
+};
+
+// NOTE(Jovan): Spirv is only filled in when a precompiled module newer than
+// all of Files exists, Knobs then feed its specialization constants
+struct preprocessed_source {
+    std::string Text;
+    std::vector<std::string> Files;
+    std::vector<variant_axis> Variants;
+    size_t VersionEnd;
+    u32 VersionLine;
+    std::vector<u32> Spirv;
+    std::vector<source_knob> Knobs;
+    std::vector<linked_library> Links;
+};
+
+struct shader_preprocessor {
+    std::unordered_map<std::string, source_file> Files;
+    std::vector<std::string> IncludeDirs;
+    std::string LastError;
+    std::vector<std::string> Linking;
+};
+
+internal void
+PreprocessorError(shader_preprocessor *pp, const std::string &message) {
+    pp->LastError = message;
+    std::cerr << "[Err] Preprocessor: " << message << std::endl;
+}
+
+internal b32
+FileExists(const std::string &path) {
+    struct stat Stat;
+    return stat(path.c_str(), &Stat) == 0 && S_ISREG(Stat.st_mode);
+}
+
+internal std::string
+ResolveInclude(shader_preprocessor *pp, const std::string &includer, const std::string &name, b32 angled) {
+    if(!angled) {
+        std::string Dir, File;
+        SplitPath(includer, Dir, File);
+        std::string Candidate = NormalizePath(Dir + "/" + name);
+        if(FileExists(Candidate)) {
+            return Candidate;
+        }
+    }
+
+    for(const std::string &Dir : pp->IncludeDirs) {
+        std::string Candidate = NormalizePath(Dir + "/" + name);
+        if(FileExists(Candidate)) {
+            return Candidate;
+        }
+    }
+    return "";
+}
+
+internal b32
+MatchWord(const char *at, const char *end, const char *word) {
+    size_t Length = strlen(word);
+    if((size_t)(end - at) < Length || memcmp(at, word, Length) != 0) {
+        return false;
+    }
+    return at + Length == end || !(isalnum((u8)at[Length]) || at[Length] == '_');
+}
+
+internal const char*
+SkipSpaces(const char *at, const char *end) {
+    while(at < end && (*at == ' ' || *at == '\t')) ++at;
+    return at;
+}
+
+internal std::vector<std::string>
+SplitWords(const char *at, const char *end) {
+    std::vector<std::string> Words;
+    while(true) {
+        at = SkipSpaces(at, end);
+        const char *WordEnd = at;
+        while(WordEnd < end && !isspace((u8)*WordEnd)) ++WordEnd;
+        if(WordEnd == at) {
+            break;
+        }
+        if(WordEnd - at >= 2 && at[0] == '/' && (at[1] == '/' || at[1] == '*')) {
+            break;
+        }
+        Words.push_back(std::string(at, WordEnd));
+        at = WordEnd;
+    }
+    return Words;
+}
+
+// NOTE(Jovan): Only looks at the first non blank character of each line and
+// at comment openers, everything else is skipped with memchr
+internal void
+ScanSourceFile(shader_preprocessor *pp, source_file *file) {
+    file->Directives.clear();
+    file->Includes.clear();
+
+    const char *Begin = file->Contents.data();
+    const char *End = Begin + file->Contents.size();
+    b32 InComment = false;
+    u32 Line = 1;
+    for(const char *LineStart = Begin; LineStart < End; ++Line) {
+        const char *LineEnd = (const char*)memchr(LineStart, '\n', End - LineStart);
+        LineEnd = LineEnd ? LineEnd + 1 : End;
+
+        const char *At = LineStart;
+        if(InComment) {
+            const char *Close = 0;
+            for(const char *Star = At; (Star = (const char*)memchr(Star, '*', LineEnd - Star)); ++Star) {
+                if(Star + 1 < LineEnd && Star[1] == '/') {
+                    Close = Star + 2;
+                    break;
+                }
+            }
+            if(!Close) {
+                LineStart = LineEnd;
+                continue;
+            }
+            InComment = false;
+            At = Close;
+        }
+
+        At = SkipSpaces(At, LineEnd);
+        if(At < LineEnd && *At == '#' && At == SkipSpaces(LineStart, LineEnd)) {
+            const char *Name = SkipSpaces(At + 1, LineEnd);
+            source_directive Directive = {};
+            Directive.Begin = LineStart - Begin;
+            Directive.End = LineEnd - Begin;
+            Directive.Line = Line;
+
+            const char *Pragma = MatchWord(Name, LineEnd, "pragma") ? SkipSpaces(Name + 6, LineEnd) : LineEnd;
+            b32 IsLink = MatchWord(Pragma, LineEnd, "link");
+            if(MatchWord(Name, LineEnd, "include") || IsLink) {
+                const char *Open = SkipSpaces(IsLink ? Pragma + 4 : Name + 7, LineEnd);
+                char Closer = *Open == '<' ? '>' : '"';
+                const char *Close = Open < LineEnd ? (const char*)memchr(Open + 1, Closer, LineEnd - Open - 1) : 0;
+                if((*Open == '"' || *Open == '<') && Close) {
+                    std::string IncludeName(Open + 1, Close);
+                    Directive.Kind = IsLink ? Directive_Link : Directive_Include;
+                    Directive.Path = ResolveInclude(pp, file->Path, IncludeName, *Open == '<');
+                    if(Directive.Path.empty()) {
+                        // NOTE(Jovan): Keep the name so the error can say what was missing
+                        Directive.Path = IncludeName;
+                    } else {
+                        file->Includes.push_back(Directive.Path);
+                    }
+                    file->Directives.push_back(Directive);
+                }
+            } else if(MatchWord(Name, LineEnd, "version")) {
+                Directive.Kind = Directive_Version;
+                file->Directives.push_back(Directive);
+            } else if(Pragma < LineEnd) {
+                if(MatchWord(Pragma, LineEnd, "once")) {
+                    Directive.Kind = Directive_PragmaOnce;
+                    file->Directives.push_back(Directive);
+                } else if(MatchWord(Pragma, LineEnd, "variant")) {
+                    Directive.Kind = Directive_Variant;
+                    Directive.Args = SplitWords(Pragma + 7, LineEnd);
+                    file->Directives.push_back(Directive);
+                }
+            }
+        }
+
+        // NOTE(Jovan): Track block comments so commented out includes stay out
+        for(const char *Slash = At; (Slash = (const char*)memchr(Slash, '/', LineEnd - Slash)); ++Slash) {
+            if(Slash + 1 >= LineEnd) break;
+            if(Slash[1] == '/') break;
+            if(Slash[1] == '*') {
+                const char *Close = 0;
+                for(const char *Star = Slash + 2; (Star = (const char*)memchr(Star, '*', LineEnd - Star)); ++Star) {
+                    if(Star + 1 < LineEnd && Star[1] == '/') {
+                        Close = Star + 2;
+                        break;
+                    }
+                }
+                if(!Close) {
+                    InComment = true;
+                    break;
+                }
+                Slash = Close - 1;
+            }
+        }
+
+        LineStart = LineEnd;
+    }
+}
+
+internal source_file*
+GetSourceFile(shader_preprocessor *pp, const std::string &path) {
+    auto Found = pp->Files.find(path);
+    if(Found != pp->Files.end()) {
+        return &Found->second;
+    }
+
+    source_file &File = pp->Files[path];
+    File.Path = path;
+    File.Missing = !ReadEntireFile(path, File.Contents);
+    if(!File.Missing) {
+        ScanSourceFile(pp, &File);
+    }
+    return &File;
+}
+
+// NOTE(Jovan): Takes the already loaded contents from the watcher, so nothing
+// else is read from disk when a file changes
+internal void
+UpdateSourceFile(shader_preprocessor *pp, const std::string &path, const std::string &contents) {
+    source_file &File = pp->Files[path];
+    File.Path = path;
+    File.Contents = contents;
+    File.Missing = false;
+    ScanSourceFile(pp, &File);
+}
+
+internal u32
+SourceFileIndex(preprocessed_source *out, const std::string &path) {
+    for(u32 FileIndex = 0; FileIndex < out->Files.size(); ++FileIndex) {
+        if(out->Files[FileIndex] == path) {
+            return FileIndex;
+        }
+    }
+    out->Files.push_back(path);
+    return (u32)out->Files.size() - 1;
+}
+
+// NOTE(Jovan): Every function defined at the top level of a library, as a
+// declaration. Structs, blocks and globals stay private to the library
+internal std::string
+LibraryPrototypes(const std::string &text) {
+    std::string Prototypes, Header;
+    u32 Depth = 0;
+    b32 LineStart = true;
+    for(size_t At = 0; At < text.size(); ++At) {
+        char C = text[At];
+        if(C == '/' && At + 1 < text.size() && (text[At + 1] == '/' || text[At + 1] == '*')) {
+            size_t Close = text[At + 1] == '/' ? text.find('\n', At) : text.find("*/", At + 2);
+            At = Close == std::string::npos ? text.size() : (text[At + 1] == '/' ? Close - 1 : Close + 1);
+            continue;
+        }
+        if(C == '#' && LineStart) {
+            size_t Close = text.find('\n', At);
+            At = Close == std::string::npos ? text.size() : Close - 1;
+            continue;
+        }
+        LineStart = C == '\n' || (LineStart && (C == ' ' || C == '\t'));
+        if(Depth > 0) {
+            Depth += C == '{';
+            Depth -= C == '}';
+            continue;
+        }
+
+        if(C == '{') {
+            if(!Header.empty() && Header.back() == ' ') Header.pop_back();
+            size_t Open = Header.find('(');
+            if(Open != std::string::npos && !Header.empty() && Header.back() == ')' &&
+               Header.compare(0, 7, "struct ") != 0) {
+                Prototypes += Header + ";\n";
+            }
+            Header.clear();
+            ++Depth;
+        } else if(C == ';' || C == '}') {
+            Header.clear();
+        } else if(isspace((u8)C)) {
+            if(!Header.empty() && Header.back() != ' ') Header += ' ';
+        } else {
+            if(!Header.empty() && Header.back() == ' ' && (C == '(' || C == ')' || C == ',')) Header.pop_back();
+            Header += C;
+        }
+    }
+    return Prototypes;
+}
+
+internal b32
+PreprocessShader(shader_preprocessor *pp, const std::string &path, preprocessed_source *out);
+
+internal b32
+AppendSourceFile(shader_preprocessor *pp, const std::string &path, preprocessed_source *out,
+                 std::vector<std::string> &stack, std::vector<std::string> &once) {
+    source_file *File = GetSourceFile(pp, path);
+    if(File->Missing) {
+        PreprocessorError(pp, "Failed reading " + path);
+        return false;
+    }
+
+    u32 FileIndex = SourceFileIndex(out, path);
+    b32 IsRoot = stack.empty();
+    stack.push_back(path);
+
+    size_t Cursor = 0;
+    for(const source_directive &Directive : File->Directives) {
+        out->Text.append(File->Contents, Cursor, Directive.Begin - Cursor);
+        Cursor = Directive.End;
+
+        switch(Directive.Kind) {
+            case Directive_Version: {
+                // NOTE(Jovan): Only the root may declare a version, included
+                // files get a blank line so the numbering stays intact
+                if(IsRoot) {
+                    out->Text.append(File->Contents, Directive.Begin, Directive.End - Directive.Begin);
+                    if(out->Text.back() != '\n') {
+                        out->Text += "\n";
+                    }
+                    out->VersionEnd = out->Text.size();
+                    out->VersionLine = Directive.Line;
+                } else {
+                    out->Text += "\n";
+                }
+            } break;
+
+            case Directive_PragmaOnce: {
+                once.push_back(path);
+                out->Text += "\n";
+            } break;
+
+            case Directive_Variant: {
+                // NOTE(Jovan): "#pragma variant NAME" is an on/off switch,
+                // "#pragma variant NAME A B C" picks one of the listed values
+                out->Text.append(File->Contents, Directive.Begin, Directive.End - Directive.Begin);
+                if(Directive.Args.empty()) {
+                    PreprocessorError(pp, path + ":" + std::to_string(Directive.Line) + ": Variant without a name");
+                    return false;
+                }
+
+                variant_axis Axis = {};
+                Axis.Name = Directive.Args[0];
+                Axis.Values.assign(Directive.Args.begin() + 1, Directive.Args.end());
+                if(Axis.Values.empty()) {
+                    Axis.Values = {"0", "1"};
+                }
+
+                b32 Duplicate = false;
+                for(const variant_axis &Existing : out->Variants) {
+                    Duplicate |= Existing.Name == Axis.Name;
+                }
+                if(!Duplicate) {
+                    out->Variants.push_back(Axis);
+                }
+            } break;
+
+            case Directive_Link: {
+                std::string Where = path + ":" + std::to_string(Directive.Line) + ": ";
+                if(!pp->Linking.empty()) {
+                    PreprocessorError(pp, Where + "Libraries can't link " + Directive.Path + ", include it instead");
+                    return false;
+                }
+                if(!FileExists(Directive.Path) && !pp->Files.count(Directive.Path)) {
+                    PreprocessorError(pp, Where + "Can't find library " + Directive.Path);
+                    return false;
+                }
+
+                b32 Linked = false;
+                for(const linked_library &Library : out->Links) {
+                    Linked |= Library.Path == Directive.Path;
+                }
+                if(Linked) {
+                    out->Text += "\n";
+                    break;
+                }
+
+                // NOTE(Jovan): Gets preprocessed on its own, none of the
+                // defines or variants of the program reach the library
+                preprocessed_source Library;
+                pp->Linking.push_back(Directive.Path);
+                b32 Success = PreprocessShader(pp, Directive.Path, &Library);
+                pp->Linking.pop_back();
+                if(!Success) {
+                    PreprocessorError(pp, Where + "Failed preprocessing " + Directive.Path + ": " + pp->LastError);
+                    return false;
+                }
+
+                out->Text += "#line 1 " + std::to_string(SourceFileIndex(out, Directive.Path)) + "\n";
+                out->Text += LibraryPrototypes(Library.Text);
+                out->Text += "#line " + std::to_string(Directive.Line + 1) + " " + std::to_string(FileIndex) + "\n";
+                for(const std::string &LibraryFile : Library.Files) {
+                    SourceFileIndex(out, LibraryFile);
+                }
+                out->Links.push_back({Directive.Path, Library.Text, Library.Files});
+            } break;
+
+            case Directive_Include: {
+                if(std::find(stack.begin(), stack.end(), Directive.Path) != stack.end()) {
+                    PreprocessorError(pp, path + ":" + std::to_string(Directive.Line) +
+                                          ": Include cycle through " + Directive.Path);
+                    return false;
+                }
+                if(!FileExists(Directive.Path) && !pp->Files.count(Directive.Path)) {
+                    PreprocessorError(pp, path + ":" + std::to_string(Directive.Line) +
+                                          ": Can't find include " + Directive.Path);
+                    return false;
+                }
+                if(std::find(once.begin(), once.end(), Directive.Path) != once.end()) {
+                    out->Text += "\n";
+                    break;
+                }
+
+                out->Text += "#line 1 " + std::to_string(SourceFileIndex(out, Directive.Path)) + "\n";
+                if(!AppendSourceFile(pp, Directive.Path, out, stack, once)) {
+                    return false;
+                }
+                if(!out->Text.empty() && out->Text.back() != '\n') {
+                    out->Text += "\n";
+                }
+                out->Text += "#line " + std::to_string(Directive.Line + 1) + " " + std::to_string(FileIndex) + "\n";
+            } break;
+        }
+    }
+    out->Text.append(File->Contents, Cursor, std::string::npos);
+
+    stack.pop_back();
+    return true;
+}
+
+internal b32
+PreprocessShader(shader_preprocessor *pp, const std::string &path, preprocessed_source *out) {
+    out->Text.clear();
+    out->Files.clear();
+    out->Variants.clear();
+    out->VersionEnd = 0;
+    out->VersionLine = 0;
+    out->Spirv.clear();
+    out->Knobs.clear();
+    out->Links.clear();
+    pp->LastError.clear();
+
+    std::vector<std::string> Stack;
+    std::vector<std::string> Once;
+    return AppendSourceFile(pp, path, out, Stack, Once);
+}
+
+// NOTE(Jovan): The stage with its linked libraries pasted at the end, for the
+// tools that want to see one self contained source. Lines inside the
+// libraries aren't mapped back to their files
+internal std::string
+InlineLinkedLibraries(const preprocessed_source *source) {
+    std::string Result = source->Text;
+    for(const linked_library &Library : source->Links) {
+        if(!Result.empty() && Result.back() != '\n') Result += "\n";
+        Result += "#line 1 " + std::to_string(std::find(source->Files.begin(), source->Files.end(), Library.Path) -
+                                              source->Files.begin()) + "\n";
+        Result += Library.Text;
+    }
+    return Result;
+}
+
+// NOTE(Jovan): Walks the include graph backwards, returns the changed file
+// and every file that ends up including it
+internal std::vector<std::string>
+CollectDependents(shader_preprocessor *pp, const std::string &path) {
+    std::unordered_map<std::string, std::vector<std::string>> IncludedBy;
+    for(const auto &Entry : pp->Files) {
+        for(const std::string &Include : Entry.second.Includes) {
+            IncludedBy[Include].push_back(Entry.first);
+        }
+    }
+
+    std::vector<std::string> Result = {path};
+    for(size_t Next = 0; Next < Result.size(); ++Next) {
+        for(const std::string &Includer : IncludedBy[Result[Next]]) {
+            if(std::find(Result.begin(), Result.end(), Includer) == Result.end()) {
+                Result.push_back(Includer);
+            }
+        }
+    }
+    return Result;
+}
+
+// NOTE(Jovan): Rewrites the source string numbers in driver logs back into
+// file names. Handles the Mesa "0:12(3):", glslang/AMD "ERROR: 0:12:" and
+// NVIDIA "0(12) :" flavours
+internal std::string
+MapShaderLog(const std::string &log, const std::vector<std::string> &files) {
+    std::string Result;
+    size_t LineStart = 0;
+    while(LineStart < log.size()) {
+        size_t LineEnd = log.find('\n', LineStart);
+        LineEnd = LineEnd == std::string::npos ? log.size() : LineEnd + 1;
+
+        size_t At = LineStart;
+        const char *Prefixes[] = {"ERROR: ", "WARNING: "};
+        for(const char *Prefix : Prefixes) {
+            if(log.compare(At, strlen(Prefix), Prefix) == 0) {
+                At += strlen(Prefix);
+                break;
+            }
+        }
+
+        size_t DigitsEnd = At;
+        while(DigitsEnd < LineEnd && isdigit((u8)log[DigitsEnd])) ++DigitsEnd;
+
+        if(DigitsEnd > At && DigitsEnd < LineEnd && (log[DigitsEnd] == ':' || log[DigitsEnd] == '(')) {
+            u32 FileIndex = (u32)atoi(log.c_str() + At);
+            if(FileIndex < files.size()) {
+                Result.append(log, LineStart, At - LineStart);
+                Result += files[FileIndex];
+                Result.append(log, DigitsEnd, LineEnd - DigitsEnd);
+                LineStart = LineEnd;
+                continue;
+            }
+        }
+
+        Result.append(log, LineStart, LineEnd - LineStart);
+        LineStart = LineEnd;
+    }
+    return Result;
+}
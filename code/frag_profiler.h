@@ -0,0 +1,195 @@
+// NOTE(Jovan): GPU profiler. Every pass gets a pair of GL_TIMESTAMP queries
+// and the frame gets one at each end. Timestamps rather than GL_TIME_ELAPSED
+// because elapsed queries can't nest and the bench already has one open
+// around the draw. The queries live in a ring a few frames deep and a slot is
+// only read back when it comes around again, a slot whose results still
+// aren't in by then is dropped instead of waited on
+
+#define PROFILER_RING_FRAMES 5
+#define PROFILER_MAX_PASSES 16
+#define PROFILER_HISTORY 240
+#define PROFILER_PRINT_SECONDS 5.0
+
+struct profiler_stats {
+    std::string Name;
+    std::vector<r64> Samples;
+    u32 Next;
+};
+
+struct profiler_frame {
+    u32 Queries[2 + PROFILER_MAX_PASSES * 2];
+    u32 Passes[PROFILER_MAX_PASSES];
+    u32 PassCount;
+    b32 Pending;
+};
+
+struct gpu_profiler {
+    b32 Enabled;
+    profiler_frame Ring[PROFILER_RING_FRAMES];
+    u32 Current;
+    b32 InPass;
+    u32 Dropped;
+    profiler_stats Frame;
+    std::vector<profiler_stats> Passes;
+    std::chrono::steady_clock::time_point LastPrint;
+};
+
+internal void
+InitGpuProfiler(gpu_profiler *profiler) {
+    for(profiler_frame &Slot : profiler->Ring) {
+        glGenQueries(2 + PROFILER_MAX_PASSES * 2, Slot.Queries);
+        Slot.PassCount = 0;
+        Slot.Pending = false;
+    }
+    profiler->Frame.Name = "Frame";
+    profiler->LastPrint = std::chrono::steady_clock::now();
+}
+
+internal void
+AddProfilerSample(profiler_stats *stats, r64 milliseconds) {
+    if(stats->Samples.size() < PROFILER_HISTORY) {
+        stats->Samples.push_back(milliseconds);
+    } else {
+        stats->Samples[stats->Next] = milliseconds;
+    }
+    stats->Next = (stats->Next + 1) % PROFILER_HISTORY;
+}
+
+internal void
+ProfilerSummary(const profiler_stats *stats, r64 *minimum, r64 *mean, r64 *p99) {
+    std::vector<r64> Sorted = stats->Samples;
+    std::sort(Sorted.begin(), Sorted.end());
+    r64 Sum = 0.0;
+    for(r64 Sample : Sorted) Sum += Sample;
+    *minimum = Sorted.front();
+    *mean = Sum / Sorted.size();
+    *p99 = Sorted[std::min(Sorted.size() - 1, (size_t)ceil(Sorted.size() * 0.99) - 1)];
+}
+
+internal void
+PrintProfilerStats(const profiler_stats *stats) {
+    if(stats->Samples.empty()) {
+        return;
+    }
+
+    r64 Minimum, Mean, P99;
+    ProfilerSummary(stats, &Minimum, &Mean, &P99);
+    char Line[160];
+    snprintf(Line, sizeof(Line), "  %-16s min %7.3f  mean %7.3f  p99 %7.3f", stats->Name.c_str(), Minimum, Mean, P99);
+    std::cout << Line << std::endl;
+}
+
+internal void
+PrintGpuProfile(gpu_profiler *profiler) {
+    if(profiler->Frame.Samples.empty()) {
+        return;
+    }
+
+    std::cout << "[Info] Profiler: GPU ms over the last " << profiler->Frame.Samples.size() << " frames";
+    if(profiler->Dropped) {
+        std::cout << ", " << profiler->Dropped << " dropped";
+    }
+    std::cout << std::endl;
+    PrintProfilerStats(&profiler->Frame);
+    for(const profiler_stats &Pass : profiler->Passes) {
+        PrintProfilerStats(&Pass);
+    }
+    profiler->Dropped = 0;
+}
+
+internal void
+CollectProfilerFrame(gpu_profiler *profiler, profiler_frame *slot) {
+    if(!slot->Pending) {
+        return;
+    }
+    slot->Pending = false;
+
+    // NOTE(Jovan): The frame's last query is the last one to finish, once it's
+    // in all the others are as well
+    i32 Available = 0;
+    glGetQueryObjectiv(slot->Queries[1], GL_QUERY_RESULT_AVAILABLE, &Available);
+    if(!Available) {
+        ++profiler->Dropped;
+        return;
+    }
+
+    GLuint64 Begin, End;
+    glGetQueryObjectui64v(slot->Queries[0], GL_QUERY_RESULT, &Begin);
+    glGetQueryObjectui64v(slot->Queries[1], GL_QUERY_RESULT, &End);
+    AddProfilerSample(&profiler->Frame, (End - Begin) / 1e6);
+    for(u32 PassIndex = 0; PassIndex < slot->PassCount; ++PassIndex) {
+        glGetQueryObjectui64v(slot->Queries[2 + PassIndex * 2], GL_QUERY_RESULT, &Begin);
+        glGetQueryObjectui64v(slot->Queries[3 + PassIndex * 2], GL_QUERY_RESULT, &End);
+        AddProfilerSample(&profiler->Passes[slot->Passes[PassIndex]], (End - Begin) / 1e6);
+    }
+}
+
+internal void
+BeginProfilerFrame(gpu_profiler *profiler) {
+    if(!profiler->Enabled) {
+        return;
+    }
+
+    profiler_frame *Slot = &profiler->Ring[profiler->Current];
+    CollectProfilerFrame(profiler, Slot);
+    Slot->PassCount = 0;
+    glQueryCounter(Slot->Queries[0], GL_TIMESTAMP);
+}
+
+// NOTE(Jovan): Passes are matched up by name, the same name in one frame
+// just adds another sample. Passes past the limit aren't timed
+internal void
+BeginGpuPass(gpu_profiler *profiler, const char *name) {
+    profiler_frame *Slot = &profiler->Ring[profiler->Current];
+    if(!profiler->Enabled || profiler->InPass || Slot->PassCount >= PROFILER_MAX_PASSES) {
+        return;
+    }
+
+    u32 PassIndex = 0;
+    while(PassIndex < profiler->Passes.size() && profiler->Passes[PassIndex].Name != name) ++PassIndex;
+    if(PassIndex == profiler->Passes.size()) {
+        profiler->Passes.push_back({name, {}, 0});
+    }
+
+    Slot->Passes[Slot->PassCount] = PassIndex;
+    glQueryCounter(Slot->Queries[2 + Slot->PassCount * 2], GL_TIMESTAMP);
+    profiler->InPass = true;
+}
+
+internal void
+EndGpuPass(gpu_profiler *profiler) {
+    if(!profiler->InPass) {
+        return;
+    }
+
+    profiler_frame *Slot = &profiler->Ring[profiler->Current];
+    glQueryCounter(Slot->Queries[3 + Slot->PassCount * 2], GL_TIMESTAMP);
+    ++Slot->PassCount;
+    profiler->InPass = false;
+}
+
+internal void
+EndProfilerFrame(gpu_profiler *profiler) {
+    if(!profiler->Enabled) {
+        return;
+    }
+
+    EndGpuPass(profiler);
+    profiler_frame *Slot = &profiler->Ring[profiler->Current];
+    glQueryCounter(Slot->Queries[1], GL_TIMESTAMP);
+    Slot->Pending = true;
+    profiler->Current = (profiler->Current + 1) % PROFILER_RING_FRAMES;
+
+    auto Now = std::chrono::steady_clock::now();
+    if(std::chrono::duration<r64>(Now - profiler->LastPrint).count() >= PROFILER_PRINT_SECONDS) {
+        PrintGpuProfile(profiler);
+        profiler->LastPrint = Now;
+    }
+}
+
+internal void
+ShutdownGpuProfiler(gpu_profiler *profiler) {
+    for(profiler_frame &Slot : profiler->Ring) {
+        glDeleteQueries(2 + PROFILER_MAX_PASSES * 2, Slot.Queries);
+    }
+}
@@ -0,0 +1,161 @@
+// NOTE(Jovan): Asynchronous readback. glReadPixels into a pixel pack buffer
+// returns right away and a fence marks when the copy is done, so with a few
+// buffers in a ring frame N is copied out while N+1 and N+2 are drawn. The
+// consumer gets the mapped buffer itself, in whatever format and type the
+// readback was set up with, and has to be done with it before returning. Having
+// to wait on a fence means the ring is too shallow for how fast frames are
+// coming, those waits are counted
+
+#define READBACK_DEFAULT_SLOTS 3
+#define READBACK_MAX_SLOTS 8
+#define READBACK_WAIT_TIMEOUT_NS 1000000000ull
+
+typedef void readback_consumer(void *user, u32 frame, const u8 *pixels, i32 width, i32 height);
+
+struct readback_slot {
+    u32 Buffer;
+    GLsync Fence;
+    u32 Frame;
+};
+
+struct frame_readback {
+    readback_slot Slots[READBACK_MAX_SLOTS];
+    u32 SlotCount;
+    u32 Oldest;
+    u32 PendingCount;
+    i32 Width;
+    i32 Height;
+    GLenum Format;
+    GLenum Type;
+    u32 PixelBytes;
+    readback_consumer *Consumer;
+    void *User;
+
+    u32 Reads;
+    u32 Waits;
+    r64 WaitMs;
+};
+
+internal u32
+ReadbackPixelBytes(GLenum format, GLenum type) {
+    u32 Components = format == GL_RED ? 1 : format == GL_RG ? 2 : format == GL_RGB ? 3 : 4;
+    return Components * (type == GL_FLOAT ? 4 : type == GL_HALF_FLOAT ? 2 : 1);
+}
+
+internal void
+InitFrameReadback(frame_readback *readback, u32 slotCount, i32 width, i32 height,
+                  readback_consumer *consumer, void *user, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE) {
+    readback->SlotCount = std::max(1u, std::min(slotCount, (u32)READBACK_MAX_SLOTS));
+    readback->Oldest = 0;
+    readback->PendingCount = 0;
+    readback->Width = width;
+    readback->Height = height;
+    readback->Format = format;
+    readback->Type = type;
+    readback->PixelBytes = ReadbackPixelBytes(format, type);
+    readback->Consumer = consumer;
+    readback->User = user;
+    readback->Reads = 0;
+    readback->Waits = 0;
+    readback->WaitMs = 0.0;
+
+    for(u32 SlotIndex = 0; SlotIndex < readback->SlotCount; ++SlotIndex) {
+        readback_slot *Slot = &readback->Slots[SlotIndex];
+        glGenBuffers(1, &Slot->Buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, Slot->Buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * readback->PixelBytes, 0, GL_STREAM_READ);
+        Slot->Fence = 0;
+        Slot->Frame = 0;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+// NOTE(Jovan): Hands the oldest pending frame to the consumer. Without wait
+// it only does so if the copy is already done
+internal b32
+DeliverOldestReadback(frame_readback *readback, b32 wait) {
+    if(!readback->PendingCount) {
+        return false;
+    }
+
+    readback_slot *Slot = &readback->Slots[readback->Oldest];
+    GLenum Status = glClientWaitSync(Slot->Fence, 0, 0);
+    if(Status == GL_TIMEOUT_EXPIRED) {
+        if(!wait) {
+            return false;
+        }
+        Status = glClientWaitSync(Slot->Fence, GL_SYNC_FLUSH_COMMANDS_BIT, READBACK_WAIT_TIMEOUT_NS);
+    }
+    glDeleteSync(Slot->Fence);
+    Slot->Fence = 0;
+    readback->Oldest = (readback->Oldest + 1) % readback->SlotCount;
+    --readback->PendingCount;
+    if(Status == GL_WAIT_FAILED || Status == GL_TIMEOUT_EXPIRED) {
+        std::cerr << "[Err] Readback: Gave up on frame " << Slot->Frame << std::endl;
+        return true;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, Slot->Buffer);
+    GLsizeiptr Size = (GLsizeiptr)readback->Width * readback->Height * readback->PixelBytes;
+    const u8 *Pixels = (const u8*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, Size, GL_MAP_READ_BIT);
+    if(Pixels) {
+        if(readback->Consumer) {
+            readback->Consumer(readback->User, Slot->Frame, Pixels, readback->Width, readback->Height);
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        ++readback->Reads;
+    } else {
+        std::cerr << "[Err] Readback: Failed mapping frame " << Slot->Frame << std::endl;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
+
+// NOTE(Jovan): Call once per frame with the finished frame bound for reading.
+// Whatever is already done gets delivered, the ring only waits when every
+// slot is still in flight. Draining at the end isn't counted as waiting
+internal void
+QueueFrameReadback(frame_readback *readback, u32 frame) {
+    while(DeliverOldestReadback(readback, false)) {
+    }
+    if(readback->PendingCount == readback->SlotCount) {
+        auto Start = std::chrono::steady_clock::now();
+        DeliverOldestReadback(readback, true);
+        ++readback->Waits;
+        readback->WaitMs += MillisecondsSince(Start);
+    }
+
+    u32 SlotIndex = (readback->Oldest + readback->PendingCount) % readback->SlotCount;
+    readback_slot *Slot = &readback->Slots[SlotIndex];
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, Slot->Buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, readback->Width, readback->Height, readback->Format, readback->Type, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    Slot->Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    Slot->Frame = frame;
+    ++readback->PendingCount;
+}
+
+internal void
+FlushFrameReadback(frame_readback *readback) {
+    while(DeliverOldestReadback(readback, true)) {
+    }
+}
+
+internal void
+PrintReadbackStats(const frame_readback *readback) {
+    char Line[160];
+    snprintf(Line, sizeof(Line), "%u frames through %u buffers, waited on %u fences (%.1f%%) for %.1f ms",
+             readback->Reads, readback->SlotCount, readback->Waits,
+             readback->Reads ? 100.0 * readback->Waits / readback->Reads : 0.0, readback->WaitMs);
+    std::cout << "[Info] Readback: " << Line << std::endl;
+}
+
+internal void
+ShutdownFrameReadback(frame_readback *readback) {
+    FlushFrameReadback(readback);
+    for(u32 SlotIndex = 0; SlotIndex < readback->SlotCount; ++SlotIndex) {
+        glDeleteBuffers(1, &readback->Slots[SlotIndex].Buffer);
+    }
+    readback->SlotCount = 0;
+}
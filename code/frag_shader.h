@@ -0,0 +1,431 @@
+// NOTE(Jovan): Shader loading, compiling and linking. Included by linux_frag.cpp
+
+struct shader_program {
+    u32 ID;
+    u32 Build;
+    u32 PendingBuild;
+    std::string VertexPath;
+    std::string FragmentPath;
+    preprocessed_source Vertex;
+    preprocessed_source Fragment;
+};
+
+// NOTE(Jovan): Counts programs swapped in. Drivers hand deleted program
+// names out again, this tells two builds apart when their IDs match
+global u32 G_PROGRAM_BUILDS;
+
+internal const char*
+ShaderTypeName(GLuint shaderType) {
+    switch(shaderType) {
+        case GL_VERTEX_SHADER: return "vertex";
+        case GL_FRAGMENT_SHADER: return "fragment";
+        case GL_GEOMETRY_SHADER: return "geometry";
+    }
+    return "unknown";
+}
+
+internal std::string
+GetShaderLog(u32 shaderID, const std::vector<std::string> *files) {
+    i32 LogLength = 0;
+    glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &LogLength);
+    std::string InfoLog(LogLength > 0 ? LogLength : 1, '\0');
+    glGetShaderInfoLog(shaderID, (GLsizei)InfoLog.size(), NULL, &InfoLog[0]);
+    InfoLog.resize(strlen(InfoLog.c_str()));
+    if(files) {
+        InfoLog = MapShaderLog(InfoLog, *files);
+    }
+    return InfoLog;
+}
+
+internal void
+PrintShaderLog(u32 shaderID, GLuint shaderType, const std::string &name, const std::vector<std::string> *files) {
+    std::cout << "Error while compiling " << ShaderTypeName(shaderType)
+              << " shader " << name << ":" << std::endl << GetShaderLog(shaderID, files) << std::endl;
+}
+
+internal void
+PrintProgramLog(u32 programID) {
+    i32 LogLength = 0;
+    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &LogLength);
+    std::string InfoLog(LogLength > 0 ? LogLength : 1, '\0');
+    glGetProgramInfoLog(programID, (GLsizei)InfoLog.size(), NULL, &InfoLog[0]);
+    std::cout << "Error while linking program:" << std::endl << InfoLog.c_str() << std::endl;
+}
+
+// NOTE(Jovan): With a log the driver output is handed back instead of printed
+internal u32
+FinishShader(u32 shaderID, GLuint shaderType, const std::string &name,
+             const std::vector<std::string> *files, std::string *log) {
+    i32 Success;
+    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &Success);
+    if(log) {
+        *log = GetShaderLog(shaderID, files);
+    }
+    if(!Success) {
+        if(!log) PrintShaderLog(shaderID, shaderType, name, files);
+        glDeleteShader(shaderID);
+        return 0;
+    }
+
+    return shaderID;
+}
+
+internal u32
+CompileShader(const std::string &source, GLuint shaderType, const std::string &name,
+              const std::vector<std::string> *files = 0, std::string *log = 0) {
+    const char *CharContent = source.c_str();
+
+    u32 ShaderID = glCreateShader(shaderType);
+    glShaderSource(ShaderID, 1, &CharContent, NULL);
+    glCompileShader(ShaderID);
+    return FinishShader(ShaderID, shaderType, name, files, log);
+}
+
+// NOTE(Jovan): Issues the compile without waiting on it, a stage with a
+// precompiled module skips the GLSL front end altogether
+internal u32
+BeginShaderStage(const preprocessed_source *source, GLuint shaderType) {
+    if(!source->Spirv.empty()) {
+        return BeginSpirvShader(source->Spirv, shaderType, source->Knobs);
+    }
+
+    const char *CharContent = source->Text.c_str();
+    u32 ShaderID = glCreateShader(shaderType);
+    glShaderSource(ShaderID, 1, &CharContent, NULL);
+    glCompileShader(ShaderID);
+    return ShaderID;
+}
+
+internal u32
+CompileShaderStage(const preprocessed_source *source, GLuint shaderType, const std::string &name) {
+    return FinishShader(BeginShaderStage(source, shaderType), shaderType, name, &source->Files, 0);
+}
+
+internal u32
+LoadAndCompileShader(std::string filename, GLuint shaderType) {
+    preprocessed_source Source = {};
+    b32 IsSpirv = filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".spv") == 0;
+    if(IsSpirv ? !ReadSpirvFile(filename, Source.Spirv) : !ReadEntireFile(filename, Source.Text)) {
+        std::cerr << "[Err] Shader: Failed reading " << filename << std::endl;
+        return 0;
+    }
+    if(IsSpirv && !GLAD_GL_ARB_gl_spirv) {
+        std::cerr << "[Err] Shader: " << filename << " needs ARB_gl_spirv" << std::endl;
+        return 0;
+    }
+
+    return FinishShader(BeginShaderStage(&Source, shaderType), shaderType, filename, 0, 0);
+}
+
+// NOTE(Jovan): Linked libraries get compiled the first time a program needs
+// them, every later program attaches the same object. One object per
+// library, stage and #version, an edited library replaces its old object
+struct library_object {
+    std::string Path;
+    std::string Version;
+    GLuint Type;
+    u64 Hash;
+    u32 ShaderID;
+    b32 Checked;
+};
+
+struct library_cache {
+    std::mutex Mutex;
+    std::vector<library_object> Objects;
+    u32 Compiles;
+    u32 Attaches;
+};
+
+global library_cache G_LIBRARY_CACHE;
+
+internal std::string
+StageVersion(const preprocessed_source *source) {
+    if(!source->VersionEnd) {
+        return "";
+    }
+    size_t Start = source->Text.rfind('\n', source->VersionEnd - 2);
+    Start = Start == std::string::npos ? 0 : Start + 1;
+    return source->Text.substr(Start, source->VersionEnd - Start);
+}
+
+// NOTE(Jovan): Expects G_LIBRARY_CACHE.Mutex to be held
+internal library_object*
+FindLibraryObject(const linked_library *library, const std::string &version, GLuint shaderType) {
+    for(library_object &Existing : G_LIBRARY_CACHE.Objects) {
+        if(Existing.Path == library->Path && Existing.Version == version && Existing.Type == shaderType) {
+            return &Existing;
+        }
+    }
+    return 0;
+}
+
+// NOTE(Jovan): Expects G_LIBRARY_CACHE.Mutex to be held. Blocks until the
+// compile is done, a failed one prints its log and is dropped
+internal void
+CheckLibraryObject(library_object *object, const linked_library *library) {
+    if(object->Checked) {
+        return;
+    }
+    object->Checked = true;
+    if(object->ShaderID) {
+        object->ShaderID = FinishShader(object->ShaderID, object->Type, library->Path, &library->Files, 0);
+    }
+}
+
+// NOTE(Jovan): Expects G_LIBRARY_CACHE.Mutex to be held. Without waiting
+// the compile is only issued, whoever links against it checks it later
+internal u32
+GetLibraryShader(const linked_library *library, const std::string &version, GLuint shaderType, b32 wait) {
+    u64 Hash = HashString(library->Text, shaderType);
+    library_object *Object = FindLibraryObject(library, version, shaderType);
+    if(Object && Object->Hash == Hash) {
+        if(wait) {
+            CheckLibraryObject(Object, library);
+        }
+        return Object->ShaderID;
+    }
+
+    if(!Object) {
+        G_LIBRARY_CACHE.Objects.push_back({library->Path, version, shaderType, 0, 0, false});
+        Object = &G_LIBRARY_CACHE.Objects.back();
+    } else if(Object->ShaderID) {
+        // NOTE(Jovan): Programs it is still attached to keep it alive
+        glDeleteShader(Object->ShaderID);
+    }
+
+    // NOTE(Jovan): A failed compile is remembered too, so the error only
+    // shows up once per edit and not once per program
+    std::string Text = version + "#line 1 0\n" + library->Text;
+    const char *CharContent = Text.c_str();
+    Object->Hash = Hash;
+    Object->ShaderID = glCreateShader(shaderType);
+    Object->Checked = false;
+    glShaderSource(Object->ShaderID, 1, &CharContent, NULL);
+    glCompileShader(Object->ShaderID);
+    ++G_LIBRARY_CACHE.Compiles;
+    if(wait) {
+        CheckLibraryObject(Object, library);
+    }
+    return Object->ShaderID;
+}
+
+// NOTE(Jovan): Stages that come in as SPIR-V already have their libraries
+// compiled in
+internal b32
+AttachLibraryShaders(u32 programID, const preprocessed_source *source, GLuint shaderType, b32 wait = true) {
+    if(source->Links.empty() || !source->Spirv.empty()) {
+        return true;
+    }
+
+    std::string Version = StageVersion(source);
+    std::lock_guard<std::mutex> Lock(G_LIBRARY_CACHE.Mutex);
+    for(const linked_library &Library : source->Links) {
+        u32 ShaderID = GetLibraryShader(&Library, Version, shaderType, wait);
+        if(!ShaderID) {
+            return false;
+        }
+        glAttachShader(programID, ShaderID);
+        ++G_LIBRARY_CACHE.Attaches;
+    }
+    return true;
+}
+
+// NOTE(Jovan): For a program linked against libraries that weren't waited
+// on. Once its link is done so are their compiles, this doesn't block then
+internal b32
+CheckLibraryShaders(const preprocessed_source *source, GLuint shaderType) {
+    if(source->Links.empty() || !source->Spirv.empty()) {
+        return true;
+    }
+
+    b32 Success = true;
+    std::string Version = StageVersion(source);
+    std::lock_guard<std::mutex> Lock(G_LIBRARY_CACHE.Mutex);
+    for(const linked_library &Library : source->Links) {
+        library_object *Object = FindLibraryObject(&Library, Version, shaderType);
+        if(Object && Object->Hash == HashString(Library.Text, shaderType)) {
+            CheckLibraryObject(Object, &Library);
+            Success &= Object->ShaderID != 0;
+        }
+    }
+    return Success;
+}
+
+internal void
+ShutdownLibraryCache() {
+    std::lock_guard<std::mutex> Lock(G_LIBRARY_CACHE.Mutex);
+    for(library_object &Object : G_LIBRARY_CACHE.Objects) {
+        if(Object.ShaderID) glDeleteShader(Object.ShaderID);
+    }
+    if(G_LIBRARY_CACHE.Compiles) {
+        std::cout << "[Info] Shader: " << G_LIBRARY_CACHE.Compiles << " library compile(s) for "
+                  << G_LIBRARY_CACHE.Attaches << " attach(es)" << std::endl;
+    }
+    G_LIBRARY_CACHE.Objects.clear();
+}
+
+internal void
+DetachShaders(u32 programID) {
+    i32 Attached = 0;
+    glGetProgramiv(programID, GL_ATTACHED_SHADERS, &Attached);
+    std::vector<u32> ShaderIDs(Attached > 0 ? Attached : 1);
+    glGetAttachedShaders(programID, Attached, 0, ShaderIDs.data());
+    for(i32 ShaderIndex = 0; ShaderIndex < Attached; ++ShaderIndex) {
+        glDetachShader(programID, ShaderIDs[ShaderIndex]);
+    }
+}
+
+// NOTE(Jovan): Links whatever was already attached plus the given stages,
+// everything is detached again afterwards
+internal u32
+LinkProgram(u32 programID, const std::vector<u32> &shaderIDs) {
+    for(u32 ShaderID : shaderIDs) {
+        glAttachShader(programID, ShaderID);
+    }
+    if(G_PROGRAM_CACHE.Enabled) {
+        glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(programID);
+    DetachShaders(programID);
+
+    i32 Success;
+    glGetProgramiv(programID, GL_LINK_STATUS, &Success);
+    if(!Success) {
+        PrintProgramLog(programID);
+        glDeleteProgram(programID);
+        return 0;
+    }
+
+    return programID;
+}
+
+global const char *FULLSCREEN_VERTEX_SOURCE = R"(#version 330 core
+void main() {
+    vec2 Position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(Position * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+// NOTE(Jovan): For the app's own passes, a fragment shader drawn with the
+// same three vertex triangle as everything else
+internal u32
+BuildFullscreenProgram(const char *fragmentSource, const std::string &name) {
+    u32 ProgramID = 0;
+    u32 VertexID = CompileShader(FULLSCREEN_VERTEX_SOURCE, GL_VERTEX_SHADER, name + " vertex");
+    u32 FragmentID = CompileShader(fragmentSource, GL_FRAGMENT_SHADER, name + " fragment");
+    if(VertexID && FragmentID) {
+        ProgramID = LinkProgram(glCreateProgram(), {VertexID, FragmentID});
+    }
+    if(VertexID) glDeleteShader(VertexID);
+    if(FragmentID) glDeleteShader(FragmentID);
+    return ProgramID;
+}
+
+// NOTE(Jovan): Programs linked from SPIR-V come out different (no uniform
+// names, for one), so the modules are part of the key. So are the linked
+// libraries, the stages themselves only carry their prototypes
+internal u64
+ShaderProgramCacheKey(const shader_program *program) {
+    std::vector<std::string> Sources = {program->Vertex.Text, program->Fragment.Text};
+    for(const preprocessed_source *Stage : {&program->Vertex, &program->Fragment}) {
+        if(!Stage->Spirv.empty()) {
+            Sources.push_back(std::string((const char*)Stage->Spirv.data(), Stage->Spirv.size() * 4));
+            for(const source_knob &Knob : Stage->Knobs) {
+                Sources.back() += Knob.Name + "=" + Knob.Value + "\n";
+            }
+        } else {
+            for(const linked_library &Library : Stage->Links) {
+                Sources.push_back(Library.Text);
+            }
+        }
+    }
+    return ProgramCacheKey(&G_PROGRAM_CACHE, Sources.data(), (u32)Sources.size());
+}
+
+internal u32
+BuildProgram(const shader_program *program) {
+    u64 CacheKey = 0;
+    if(G_PROGRAM_CACHE.Enabled) {
+        CacheKey = ShaderProgramCacheKey(program);
+        u32 CachedID = LoadCachedProgram(&G_PROGRAM_CACHE, CacheKey);
+        if(CachedID) {
+            return CachedID;
+        }
+    }
+
+    u32 VertexID = CompileShaderStage(&program->Vertex, GL_VERTEX_SHADER, program->VertexPath);
+    u32 FragmentID = CompileShaderStage(&program->Fragment, GL_FRAGMENT_SHADER, program->FragmentPath);
+
+    u32 ProgramID = 0;
+    if(VertexID && FragmentID) {
+        ProgramID = glCreateProgram();
+        if(AttachLibraryShaders(ProgramID, &program->Vertex, GL_VERTEX_SHADER) &&
+           AttachLibraryShaders(ProgramID, &program->Fragment, GL_FRAGMENT_SHADER)) {
+            ProgramID = LinkProgram(ProgramID, {VertexID, FragmentID});
+        } else {
+            glDeleteProgram(ProgramID);
+            ProgramID = 0;
+        }
+    }
+
+    if(VertexID) glDeleteShader(VertexID);
+    if(FragmentID) glDeleteShader(FragmentID);
+
+    if(ProgramID && G_PROGRAM_CACHE.Enabled) {
+        StoreCachedProgram(&G_PROGRAM_CACHE, CacheKey, ProgramID);
+    }
+    return ProgramID;
+}
+
+// NOTE(Jovan): Runs both stages through the preprocessor, the sources only
+// get replaced if both of them preprocess cleanly
+internal b32
+PreprocessShaderProgram(shader_preprocessor *pp, shader_program *program) {
+    preprocessed_source Vertex, Fragment;
+    if(!PreprocessShader(pp, program->VertexPath, &Vertex) ||
+       !PreprocessShader(pp, program->FragmentPath, &Fragment)) {
+        return false;
+    }
+
+    if(AttachSpirvModules(&Vertex, &Fragment, program->VertexPath, program->FragmentPath)) {
+        std::cout << "[Info] Shader: Using precompiled SPIR-V for " << program->FragmentPath << std::endl;
+    }
+    program->Vertex = std::move(Vertex);
+    program->Fragment = std::move(Fragment);
+    return true;
+}
+
+internal b32
+ReadShaderProgram(shader_preprocessor *pp, shader_program *program,
+                  const std::string &vertexPath, const std::string &fragmentPath) {
+    program->VertexPath = NormalizePath(vertexPath);
+    program->FragmentPath = NormalizePath(fragmentPath);
+    return PreprocessShaderProgram(pp, program);
+}
+
+internal b32
+ShaderProgramDependsOn(const shader_program *program, const std::vector<std::string> &files) {
+    return std::find(files.begin(), files.end(), program->VertexPath) != files.end() ||
+           std::find(files.begin(), files.end(), program->FragmentPath) != files.end();
+}
+
+internal b32
+LoadShaderProgram(shader_preprocessor *pp, shader_program *program,
+                  const std::string &vertexPath, const std::string &fragmentPath) {
+    if(!ReadShaderProgram(pp, program, vertexPath, fragmentPath)) {
+        return false;
+    }
+
+    program->ID = BuildProgram(program);
+    program->Build = ++G_PROGRAM_BUILDS;
+    RegisterSpirvUniforms(program->ID, &program->Vertex, &program->Fragment);
+    return program->ID != 0;
+}
+
+internal void
+DeleteShaderProgram(shader_program *program) {
+    if(program->ID) {
+        glDeleteProgram(program->ID);
+        program->ID = 0;
+    }
+}
@@ -0,0 +1,246 @@
+// NOTE(Jovan): Uniform specialization. Uniforms that haven't changed for a
+// while get baked into a copy of the program as constants so the driver can
+// fold them and unroll the loops around them. The copy builds in the
+// background, the moment one of the baked values changes the generic
+// program takes over again
+
+#define SPECIALIZE_STABLE_FRAMES 120
+
+struct uniform_specializer {
+    b32 Enabled;
+    u32 GenericID;
+    shader_program Program;
+    std::vector<u32> Baked;
+    std::vector<std::vector<u8>> BakedValues;
+    b32 GaveUp;
+    u32 SettleUntil;
+};
+
+internal b32
+CanBakeUniform(GLenum type) {
+    switch(type) {
+        case GL_FLOAT: case GL_FLOAT_VEC2: case GL_FLOAT_VEC3: case GL_FLOAT_VEC4:
+        case GL_INT: case GL_INT_VEC2: case GL_INT_VEC3: case GL_INT_VEC4:
+        case GL_UNSIGNED_INT: case GL_UNSIGNED_INT_VEC2: case GL_UNSIGNED_INT_VEC3: case GL_UNSIGNED_INT_VEC4:
+        case GL_BOOL: case GL_BOOL_VEC2: case GL_BOOL_VEC3: case GL_BOOL_VEC4: {
+            return true;
+        }
+    }
+    return false;
+}
+
+internal u32
+UniformComponents(GLenum type) {
+    switch(type) {
+        case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_BOOL_VEC2: return 2;
+        case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_BOOL_VEC3: return 3;
+        case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_BOOL_VEC4: return 4;
+    }
+    return 1;
+}
+
+// NOTE(Jovan): Floats are printed with enough digits to round trip, so the
+// constant is bit for bit what the uniform was
+internal b32
+FormatUniformConstant(const uniform_slot *slot, std::string &out) {
+    u32 Components = UniformComponents(slot->Type);
+    if(slot->Size != 1 || slot->Value.size() != Components * 4) {
+        return false;
+    }
+
+    std::string Values;
+    for(u32 Component = 0; Component < Components; ++Component) {
+        char Buffer[32];
+        const u8 *At = slot->Value.data() + Component * 4;
+        switch(slot->Type) {
+            case GL_FLOAT: case GL_FLOAT_VEC2: case GL_FLOAT_VEC3: case GL_FLOAT_VEC4: {
+                r32 Value;
+                memcpy(&Value, At, 4);
+                if(!std::isfinite(Value)) {
+                    return false;
+                }
+                snprintf(Buffer, sizeof(Buffer), "%.9g", Value);
+                if(!strpbrk(Buffer, ".e")) strcat(Buffer, ".0");
+            } break;
+            case GL_UNSIGNED_INT: case GL_UNSIGNED_INT_VEC2: case GL_UNSIGNED_INT_VEC3: case GL_UNSIGNED_INT_VEC4: {
+                u32 Value;
+                memcpy(&Value, At, 4);
+                snprintf(Buffer, sizeof(Buffer), "%uu", Value);
+            } break;
+            case GL_BOOL: case GL_BOOL_VEC2: case GL_BOOL_VEC3: case GL_BOOL_VEC4: {
+                i32 Value;
+                memcpy(&Value, At, 4);
+                snprintf(Buffer, sizeof(Buffer), "%s", Value ? "true" : "false");
+            } break;
+            default: {
+                i32 Value;
+                memcpy(&Value, At, 4);
+                snprintf(Buffer, sizeof(Buffer), "%d", Value);
+            } break;
+        }
+        if(Component) Values += ", ";
+        Values += Buffer;
+    }
+
+    out = Components == 1 ? Values : "(" + Values + ")";
+    return true;
+}
+
+// NOTE(Jovan): Swaps "uniform TYPE NAME;" for "const TYPE NAME = VALUE;".
+// Declarations with several names, arrays or blocks are left alone
+internal void
+BakeUniformDeclarations(std::string &source, const uniform_table *table, const std::vector<u32> &handles,
+                        std::vector<u32> &baked) {
+    for(size_t At = source.find("uniform"); At != std::string::npos; At = source.find("uniform", At + 1)) {
+        if((At > 0 && IsIdentifierChar(source[At - 1])) || IsIdentifierChar(source[At + 7])) {
+            continue;
+        }
+
+        std::vector<std::string> Words;
+        size_t Cursor = At + 7;
+        while(Words.size() < 3) {
+            while(Cursor < source.size() && (source[Cursor] == ' ' || source[Cursor] == '\t')) ++Cursor;
+            size_t WordStart = Cursor;
+            while(Cursor < source.size() && IsIdentifierChar(source[Cursor])) ++Cursor;
+            if(Cursor == WordStart) break;
+            Words.push_back(source.substr(WordStart, Cursor - WordStart));
+            if(Words.size() == 1 && (Words[0] == "highp" || Words[0] == "mediump" || Words[0] == "lowp")) {
+                Words.pop_back();
+            }
+            if(Words.size() == 2) break;
+        }
+        while(Cursor < source.size() && (source[Cursor] == ' ' || source[Cursor] == '\t')) ++Cursor;
+        if(Words.size() != 2 || Cursor >= source.size() || source[Cursor] != ';') {
+            continue;
+        }
+
+        for(u32 Handle : handles) {
+            const uniform_slot *Slot = &table->Slots[Handle];
+            std::string Value;
+            if(Slot->Name != Words[1] || !FormatUniformConstant(Slot, Value)) {
+                continue;
+            }
+            if(UniformComponents(Slot->Type) > 1) {
+                Value = Words[0] + Value;
+            }
+            std::string Constant = "const " + Words[0] + " " + Words[1] + " = " + Value + ";";
+            source.replace(At, Cursor + 1 - At, Constant);
+            At += Constant.size() - 1;
+            if(std::find(baked.begin(), baked.end(), Handle) == baked.end()) {
+                baked.push_back(Handle);
+            }
+            break;
+        }
+    }
+}
+
+internal void
+DropSpecialization(compile_queue *queue, uniform_specializer *spec) {
+    if(spec->Program.PendingBuild) {
+        CancelCompileJob(queue, spec->Program.PendingBuild);
+        spec->Program.PendingBuild = 0;
+    }
+    DeleteShaderProgram(&spec->Program);
+    spec->Baked.clear();
+    spec->BakedValues.clear();
+    spec->GaveUp = false;
+}
+
+internal void
+RequestSpecialization(compile_queue *queue, uniform_specializer *spec,
+                      const shader_program *generic, const uniform_table *table) {
+    std::vector<u32> Stable;
+    for(u32 Handle = 0; Handle < table->Slots.size(); ++Handle) {
+        const uniform_slot *Slot = &table->Slots[Handle];
+        if(Slot->Location >= 0 && !Slot->Value.empty() && CanBakeUniform(Slot->Type) &&
+           table->Frame - Slot->ChangedFrame >= SPECIALIZE_STABLE_FRAMES) {
+            Stable.push_back(Handle);
+        }
+    }
+    if(Stable.empty()) {
+        return;
+    }
+
+    spec->Program = {};
+    spec->Program.VertexPath = generic->VertexPath;
+    spec->Program.FragmentPath = generic->FragmentPath;
+    spec->Program.Vertex = generic->Vertex;
+    spec->Program.Fragment = generic->Fragment;
+    // NOTE(Jovan): The baked constants only exist in the text
+    spec->Program.Vertex.Spirv.clear();
+    spec->Program.Fragment.Spirv.clear();
+    BakeUniformDeclarations(spec->Program.Vertex.Text, table, Stable, spec->Baked);
+    BakeUniformDeclarations(spec->Program.Fragment.Text, table, Stable, spec->Baked);
+    if(spec->Baked.empty()) {
+        // NOTE(Jovan): Nothing we know how to rewrite, don't try again until
+        // the generic program changes
+        spec->GaveUp = true;
+        return;
+    }
+
+    for(u32 Handle : spec->Baked) {
+        spec->BakedValues.push_back(table->Slots[Handle].Value);
+    }
+    RequestProgramBuild(queue, &spec->Program);
+}
+
+// NOTE(Jovan): Returns the program to draw with, the specialized one only
+// while every baked value still matches
+internal u32
+UpdateSpecialization(compile_queue *queue, uniform_specializer *spec,
+                     const shader_program *generic, const uniform_table *table) {
+    if(!spec->Enabled || !generic->ID || generic->ID != spec->GenericID) {
+        DropSpecialization(queue, spec);
+        spec->GenericID = generic->ID;
+        if(!spec->Enabled) {
+            return generic->ID;
+        }
+    }
+
+    for(size_t BakedIndex = 0; BakedIndex < spec->BakedValues.size(); ++BakedIndex) {
+        if(table->Slots[spec->Baked[BakedIndex]].Value != spec->BakedValues[BakedIndex]) {
+            if(spec->Program.ID) {
+                std::cout << "[Info] Specialize: " << table->Slots[spec->Baked[BakedIndex]].Name
+                          << " changed, back to the generic program" << std::endl;
+            }
+            // NOTE(Jovan): Whatever changed probably keeps changing for a bit,
+            // give it time to settle so it can be baked along with the rest
+            DropSpecialization(queue, spec);
+            spec->SettleUntil = table->Frame + SPECIALIZE_STABLE_FRAMES;
+            break;
+        }
+    }
+
+    if(UpdateProgramBuild(queue, &spec->Program)) {
+        std::cout << "[Info] Specialize: Baked " << spec->Baked.size() << " uniform(s) into "
+                  << spec->Program.FragmentPath << std::endl;
+    }
+
+    // NOTE(Jovan): Only look for candidates while the generic program is the
+    // one reflected, baked uniforms have no location in the specialized one
+    if(spec->Baked.empty() && !spec->GaveUp && table->ProgramID == generic->ID &&
+       (i32)(table->Frame - spec->SettleUntil) >= 0) {
+        RequestSpecialization(queue, spec, generic, table);
+    }
+
+    return spec->Program.ID ? spec->Program.ID : generic->ID;
+}
+
+// NOTE(Jovan): For the idle check, true while some uniform that could be
+// baked is still counting frames towards SPECIALIZE_STABLE_FRAMES
+internal b32
+SpecializationSettling(const uniform_specializer *spec, const uniform_table *table) {
+    if(!spec->Enabled || !spec->GenericID || !spec->Baked.empty() || spec->GaveUp) {
+        return false;
+    }
+    if((i32)(table->Frame - spec->SettleUntil) < 0) {
+        return true;
+    }
+    for(const uniform_slot &Slot : table->Slots) {
+        if(Slot.Location >= 0 && !Slot.Value.empty() && CanBakeUniform(Slot.Type) &&
+           table->Frame - Slot.ChangedFrame < SPECIALIZE_STABLE_FRAMES) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,270 @@
+// NOTE(Jovan): Precompiled SPIR-V through ARB_gl_spirv. A "<shader>.spv"
+// written by spirv.sh is used in place of the GLSL whenever it's newer than
+// every file the shader pulls in, so editing the GLSL falls back to the text
+// path on its own. Variant axes become specialization constants and are
+// matched up by the names left in the module. The driver doesn't keep the
+// names of plain uniforms, those are looked up by location instead
+
+#define SPIRV_MAGIC 0x07230203
+
+#define SpvOpName 5
+#define SpvOpEntryPoint 15
+#define SpvOpTypeBool 20
+#define SpvOpTypeInt 21
+#define SpvOpTypeFloat 22
+#define SpvOpSpecConstantTrue 48
+#define SpvOpSpecConstantFalse 49
+#define SpvOpSpecConstant 50
+#define SpvOpVariable 59
+#define SpvOpDecorate 71
+#define SpvDecorationSpecId 1
+#define SpvDecorationLocation 30
+#define SpvStorageClassUniformConstant 0
+
+enum spirv_constant_type {
+    SpirvConstant_Bool,
+    SpirvConstant_Int,
+    SpirvConstant_Float,
+};
+
+struct spirv_constant {
+    std::string Name;
+    u32 SpecID;
+    spirv_constant_type Type;
+};
+
+struct spirv_uniform {
+    std::string Name;
+    i32 Location;
+};
+
+struct spirv_module {
+    std::string EntryPoint;
+    std::vector<spirv_constant> Constants;
+    std::vector<spirv_uniform> Uniforms;
+};
+
+global std::unordered_map<u32, std::vector<spirv_uniform>> G_SPIRV_UNIFORMS;
+
+internal std::string
+SpirvString(const std::vector<u32> &words, size_t at, size_t end) {
+    std::string Result;
+    for(; at < end; ++at) {
+        for(u32 Byte = 0; Byte < 4; ++Byte) {
+            char C = (char)((words[at] >> (Byte * 8)) & 0xFF);
+            if(!C) return Result;
+            Result += C;
+        }
+    }
+    return Result;
+}
+
+// NOTE(Jovan): Only looks at the handful of instructions that tell us the
+// entry point, which specialization constants go by which name and where
+// the uniforms ended up
+internal b32
+ParseSpirvModule(const std::vector<u32> &words, spirv_module *out) {
+    if(words.size() < 5 || words[0] != SPIRV_MAGIC) {
+        return false;
+    }
+
+    std::unordered_map<u32, std::string> Names;
+    std::unordered_map<u32, u32> SpecIDs;
+    std::unordered_map<u32, i32> Locations;
+    std::unordered_map<u32, spirv_constant_type> Types;
+    std::vector<std::pair<u32, spirv_constant_type>> Constants;
+    std::vector<u32> Uniforms;
+
+    for(size_t At = 5; At < words.size();) {
+        u32 Opcode = words[At] & 0xFFFF;
+        u32 Count = words[At] >> 16;
+        if(!Count || At + Count > words.size()) {
+            return false;
+        }
+
+        switch(Opcode) {
+            case SpvOpName: {
+                Names[words[At + 1]] = SpirvString(words, At + 2, At + Count);
+            } break;
+            case SpvOpEntryPoint: {
+                if(out->EntryPoint.empty()) out->EntryPoint = SpirvString(words, At + 3, At + Count);
+            } break;
+            case SpvOpTypeBool: {
+                Types[words[At + 1]] = SpirvConstant_Bool;
+            } break;
+            case SpvOpTypeInt: {
+                Types[words[At + 1]] = SpirvConstant_Int;
+            } break;
+            case SpvOpTypeFloat: {
+                Types[words[At + 1]] = SpirvConstant_Float;
+            } break;
+            case SpvOpSpecConstantTrue: case SpvOpSpecConstantFalse: {
+                Constants.push_back({words[At + 2], SpirvConstant_Bool});
+            } break;
+            case SpvOpSpecConstant: {
+                Constants.push_back({words[At + 2], Types.count(words[At + 1]) ? Types[words[At + 1]] : SpirvConstant_Int});
+            } break;
+            case SpvOpVariable: {
+                if(Count >= 4 && words[At + 3] == SpvStorageClassUniformConstant) {
+                    Uniforms.push_back(words[At + 2]);
+                }
+            } break;
+            case SpvOpDecorate: {
+                if(Count >= 4 && words[At + 2] == SpvDecorationSpecId) {
+                    SpecIDs[words[At + 1]] = words[At + 3];
+                } else if(Count >= 4 && words[At + 2] == SpvDecorationLocation) {
+                    Locations[words[At + 1]] = (i32)words[At + 3];
+                }
+            } break;
+        }
+        At += Count;
+    }
+
+    for(const auto &Constant : Constants) {
+        auto SpecID = SpecIDs.find(Constant.first);
+        if(SpecID != SpecIDs.end()) {
+            out->Constants.push_back({Names[Constant.first], SpecID->second, Constant.second});
+        }
+    }
+    for(u32 Uniform : Uniforms) {
+        auto Location = Locations.find(Uniform);
+        if(Location != Locations.end() && !Names[Uniform].empty()) {
+            out->Uniforms.push_back({Names[Uniform], Location->second});
+        }
+    }
+    if(out->EntryPoint.empty()) {
+        out->EntryPoint = "main";
+    }
+    return true;
+}
+
+internal b32
+ReadSpirvFile(const std::string &path, std::vector<u32> &out) {
+    std::string Data;
+    if(!ReadEntireFile(path, Data) || Data.size() < 20 || Data.size() % 4) {
+        return false;
+    }
+
+    out.resize(Data.size() / 4);
+    memcpy(out.data(), Data.data(), Data.size());
+    // NOTE(Jovan): Modules are allowed to come in either byte order
+    if(out[0] == __builtin_bswap32(SPIRV_MAGIC)) {
+        for(u32 &Word : out) Word = __builtin_bswap32(Word);
+    }
+    return out[0] == SPIRV_MAGIC;
+}
+
+internal b32
+IsSpirvFresh(const std::string &spirvPath, const std::vector<std::string> &files) {
+    struct stat Spirv;
+    if(stat(spirvPath.c_str(), &Spirv) < 0) {
+        return false;
+    }
+    for(const std::string &File : files) {
+        struct stat Source;
+        if(stat(File.c_str(), &Source) < 0 || Source.st_mtime > Spirv.st_mtime) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// NOTE(Jovan): GLSL and SPIR-V stages can't be linked together, so either
+// both stages have a fresh module or both stay on the text path
+internal b32
+AttachSpirvModules(preprocessed_source *vertex, preprocessed_source *fragment,
+                   const std::string &vertexPath, const std::string &fragmentPath) {
+    vertex->Spirv.clear();
+    fragment->Spirv.clear();
+    if(!GLAD_GL_ARB_gl_spirv) {
+        return false;
+    }
+
+    if(!IsSpirvFresh(vertexPath + ".spv", vertex->Files) || !IsSpirvFresh(fragmentPath + ".spv", fragment->Files) ||
+       !ReadSpirvFile(vertexPath + ".spv", vertex->Spirv) || !ReadSpirvFile(fragmentPath + ".spv", fragment->Spirv)) {
+        vertex->Spirv.clear();
+        fragment->Spirv.clear();
+        return false;
+    }
+    return true;
+}
+
+internal u32
+SpirvConstantValue(spirv_constant_type type, const std::string &value) {
+    switch(type) {
+        case SpirvConstant_Bool: return atof(value.c_str()) != 0.0;
+        case SpirvConstant_Float: {
+            r32 Float = (r32)atof(value.c_str());
+            u32 Bits;
+            memcpy(&Bits, &Float, sizeof(Bits));
+            return Bits;
+        }
+        default: return (u32)atoi(value.c_str());
+    }
+}
+
+// NOTE(Jovan): Creates and specializes the shader, the caller checks
+// GL_COMPILE_STATUS like it would after glCompileShader
+internal u32
+BeginSpirvShader(const std::vector<u32> &words, GLuint shaderType, const std::vector<source_knob> &knobs) {
+    spirv_module Module;
+    u32 ShaderID = glCreateShader(shaderType);
+    if(!ParseSpirvModule(words, &Module)) {
+        return ShaderID;
+    }
+
+    std::vector<u32> Indices, Values;
+    for(const spirv_constant &Constant : Module.Constants) {
+        for(const source_knob &Knob : knobs) {
+            if(Knob.Name == Constant.Name) {
+                Indices.push_back(Constant.SpecID);
+                Values.push_back(SpirvConstantValue(Constant.Type, Knob.Value));
+                break;
+            }
+        }
+    }
+
+    glShaderBinary(1, &ShaderID, GL_SHADER_BINARY_FORMAT_SPIR_V_ARB, words.data(), (GLsizei)(words.size() * 4));
+    glSpecializeShaderARB(ShaderID, Module.EntryPoint.c_str(), (GLuint)Indices.size(), Indices.data(), Values.data());
+    return ShaderID;
+}
+
+// NOTE(Jovan): Called with every freshly built program, text programs just
+// clear whatever an earlier program with the same ID left behind
+internal void
+RegisterSpirvUniforms(u32 programID, const preprocessed_source *vertex, const preprocessed_source *fragment) {
+    G_SPIRV_UNIFORMS.erase(programID);
+    if(!programID || vertex->Spirv.empty()) {
+        return;
+    }
+
+    std::vector<spirv_uniform> &Uniforms = G_SPIRV_UNIFORMS[programID];
+    for(const preprocessed_source *Stage : {vertex, fragment}) {
+        spirv_module Module;
+        if(!ParseSpirvModule(Stage->Spirv, &Module)) {
+            continue;
+        }
+        for(const spirv_uniform &Uniform : Module.Uniforms) {
+            b32 Known = false;
+            for(const spirv_uniform &Existing : Uniforms) {
+                Known |= Existing.Location == Uniform.Location;
+            }
+            if(!Known) {
+                Uniforms.push_back(Uniform);
+            }
+        }
+    }
+}
+
+internal const char*
+FindSpirvUniformName(u32 programID, i32 location) {
+    auto Program = G_SPIRV_UNIFORMS.find(programID);
+    if(Program != G_SPIRV_UNIFORMS.end()) {
+        for(const spirv_uniform &Uniform : Program->second) {
+            if(Uniform.Location == location) {
+                return Uniform.Name.c_str();
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,272 @@
+// NOTE(Jovan): Uniform reflection. Every program gets introspected once after
+// it's linked, the frame loop only ever deals with integer handles. Handles
+// stay valid across hot swaps, only their locations get looked up again
+
+struct uniform_info {
+    u64 NameHash;
+    std::string Name;
+    i32 Location;
+    GLenum Type;
+    i32 Size;
+};
+
+struct uniform_slot {
+    u64 NameHash;
+    std::string Name;
+    i32 Location;
+    GLenum Type;
+    i32 Size;
+    b32 Dirty;
+    b32 Warned;
+    u32 ChangedFrame;
+    std::vector<u8> Value;
+};
+
+struct uniform_table {
+    u32 ProgramID;
+    std::vector<uniform_info> Active;
+    std::vector<uniform_slot> Slots;
+    u32 Uploads;
+    u32 Frame;
+};
+
+internal u64
+UniformNameHash(const std::string &name) {
+    return HashString(name, 0);
+}
+
+internal const uniform_info*
+FindActiveUniform(const uniform_table *table, u64 nameHash) {
+    for(const uniform_info &Info : table->Active) {
+        if(Info.NameHash == nameHash) {
+            return &Info;
+        }
+    }
+    return 0;
+}
+
+internal void
+ResolveUniformSlot(const uniform_table *table, uniform_slot *slot) {
+    const uniform_info *Info = FindActiveUniform(table, slot->NameHash);
+    slot->Location = Info ? Info->Location : -1;
+    slot->Type = Info ? Info->Type : 0;
+    slot->Size = Info ? Info->Size : 0;
+    slot->Warned = false;
+    // NOTE(Jovan): A fresh program starts with all uniforms zeroed, whatever
+    // was set before has to go up again
+    slot->Dirty = !slot->Value.empty();
+}
+
+// NOTE(Jovan): Cheap to call every frame, only does work when the program changed
+internal void
+ReflectProgramUniforms(uniform_table *table, u32 programID) {
+    if(table->ProgramID == programID) {
+        return;
+    }
+
+    table->ProgramID = programID;
+    table->Active.clear();
+    if(programID) {
+        i32 Count = 0, MaxLength = 0;
+        glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &Count);
+        glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &MaxLength);
+        std::string Name(MaxLength > 0 ? MaxLength : 1, '\0');
+
+        for(i32 UniformIndex = 0; UniformIndex < Count; ++UniformIndex) {
+            GLsizei Length = 0;
+            uniform_info Info = {};
+            glGetActiveUniform(programID, UniformIndex, (GLsizei)Name.size(), &Length, &Info.Size, &Info.Type, &Name[0]);
+            Info.Name.assign(Name.data(), Length);
+            Info.Location = glGetUniformLocation(programID, Info.Name.c_str());
+            if(Info.Name.empty()) {
+                // NOTE(Jovan): Programs linked from SPIR-V have no names
+                GLenum Property = GL_LOCATION;
+                glGetProgramResourceiv(programID, GL_UNIFORM, UniformIndex, 1, &Property, 1, 0, &Info.Location);
+                const char *SpirvName = FindSpirvUniformName(programID, Info.Location);
+                Info.Name = SpirvName ? SpirvName : "";
+                if(Info.Name.empty()) continue;
+            }
+            // NOTE(Jovan): Uniform block members have no location, arrays
+            // come back as "name[0]" and are addressed by their plain name
+            if(Info.Location < 0) {
+                continue;
+            }
+            if(Info.Name.size() > 3 && Info.Name.compare(Info.Name.size() - 3, 3, "[0]") == 0) {
+                Info.Name.resize(Info.Name.size() - 3);
+            }
+            Info.NameHash = UniformNameHash(Info.Name);
+            table->Active.push_back(Info);
+        }
+    }
+
+    for(uniform_slot &Slot : table->Slots) {
+        ResolveUniformSlot(table, &Slot);
+    }
+}
+
+internal u32
+GetUniformHandle(uniform_table *table, const std::string &name) {
+    u64 NameHash = UniformNameHash(name);
+    for(u32 Handle = 0; Handle < table->Slots.size(); ++Handle) {
+        if(table->Slots[Handle].NameHash == NameHash) {
+            return Handle;
+        }
+    }
+
+    uniform_slot Slot = {};
+    Slot.NameHash = NameHash;
+    Slot.Name = name;
+    ResolveUniformSlot(table, &Slot);
+    table->Slots.push_back(Slot);
+    return (u32)table->Slots.size() - 1;
+}
+
+internal b32
+UniformTypeMatches(GLenum reflected, GLenum type) {
+    if(reflected == type) {
+        return true;
+    }
+
+    // NOTE(Jovan): Samplers and bools are set through ints
+    switch(reflected) {
+        case GL_BOOL: case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_BUFFER: {
+            return type == GL_INT;
+        }
+        case GL_BOOL_VEC2: return type == GL_INT_VEC2;
+        case GL_BOOL_VEC3: return type == GL_INT_VEC3;
+        case GL_BOOL_VEC4: return type == GL_INT_VEC4;
+    }
+    return false;
+}
+
+// NOTE(Jovan): Only marks the slot dirty when the bytes actually changed
+internal void
+SetUniformData(uniform_table *table, u32 handle, GLenum type, const void *data, size_t size) {
+    if(handle >= table->Slots.size()) {
+        return;
+    }
+
+    uniform_slot *Slot = &table->Slots[handle];
+    if(Slot->Location >= 0 && !UniformTypeMatches(Slot->Type, type)) {
+        if(!Slot->Warned) {
+            std::cerr << "[Err] Uniforms: Type mismatch setting " << Slot->Name << std::endl;
+            Slot->Warned = true;
+        }
+        return;
+    }
+
+    if(Slot->Value.size() == size && memcmp(Slot->Value.data(), data, size) == 0) {
+        return;
+    }
+    Slot->Value.assign((const u8*)data, (const u8*)data + size);
+    Slot->Dirty = true;
+    Slot->ChangedFrame = table->Frame;
+}
+
+internal void
+SetUniform1f(uniform_table *table, u32 handle, r32 x) {
+    SetUniformData(table, handle, GL_FLOAT, &x, sizeof(x));
+}
+
+internal void
+SetUniform2f(uniform_table *table, u32 handle, r32 x, r32 y) {
+    r32 Value[2] = {x, y};
+    SetUniformData(table, handle, GL_FLOAT_VEC2, Value, sizeof(Value));
+}
+
+internal void
+SetUniform3f(uniform_table *table, u32 handle, r32 x, r32 y, r32 z) {
+    r32 Value[3] = {x, y, z};
+    SetUniformData(table, handle, GL_FLOAT_VEC3, Value, sizeof(Value));
+}
+
+internal void
+SetUniform4f(uniform_table *table, u32 handle, r32 x, r32 y, r32 z, r32 w) {
+    r32 Value[4] = {x, y, z, w};
+    SetUniformData(table, handle, GL_FLOAT_VEC4, Value, sizeof(Value));
+}
+
+internal void
+SetUniform1i(uniform_table *table, u32 handle, i32 x) {
+    SetUniformData(table, handle, GL_INT, &x, sizeof(x));
+}
+
+internal void
+UploadUniformSlot(const uniform_slot *slot) {
+    const r32 *F = (const r32*)slot->Value.data();
+    const i32 *I = (const i32*)slot->Value.data();
+    const u32 *U = (const u32*)slot->Value.data();
+    i32 Bytes = (i32)slot->Value.size();
+
+    switch(slot->Type) {
+        case GL_FLOAT: glUniform1fv(slot->Location, Bytes / 4, F); break;
+        case GL_FLOAT_VEC2: glUniform2fv(slot->Location, Bytes / 8, F); break;
+        case GL_FLOAT_VEC3: glUniform3fv(slot->Location, Bytes / 12, F); break;
+        case GL_FLOAT_VEC4: glUniform4fv(slot->Location, Bytes / 16, F); break;
+        case GL_INT_VEC2: case GL_BOOL_VEC2: glUniform2iv(slot->Location, Bytes / 8, I); break;
+        case GL_INT_VEC3: case GL_BOOL_VEC3: glUniform3iv(slot->Location, Bytes / 12, I); break;
+        case GL_INT_VEC4: case GL_BOOL_VEC4: glUniform4iv(slot->Location, Bytes / 16, I); break;
+        case GL_UNSIGNED_INT: glUniform1uiv(slot->Location, Bytes / 4, U); break;
+        case GL_UNSIGNED_INT_VEC2: glUniform2uiv(slot->Location, Bytes / 8, U); break;
+        case GL_UNSIGNED_INT_VEC3: glUniform3uiv(slot->Location, Bytes / 12, U); break;
+        case GL_UNSIGNED_INT_VEC4: glUniform4uiv(slot->Location, Bytes / 16, U); break;
+        case GL_FLOAT_MAT2: glUniformMatrix2fv(slot->Location, Bytes / 16, GL_FALSE, F); break;
+        case GL_FLOAT_MAT3: glUniformMatrix3fv(slot->Location, Bytes / 36, GL_FALSE, F); break;
+        case GL_FLOAT_MAT4: glUniformMatrix4fv(slot->Location, Bytes / 64, GL_FALSE, F); break;
+        default: glUniform1iv(slot->Location, Bytes / 4, I); break;
+    }
+}
+
+internal b32
+UniformIsRead(const uniform_table *table, u32 handle) {
+    return handle < table->Slots.size() && table->Slots[handle].Location >= 0;
+}
+
+// NOTE(Jovan): Whether anything the reflected program reads changed since
+// the last upload
+internal b32
+ReadUniformsChanged(const uniform_table *table) {
+    for(const uniform_slot &Slot : table->Slots) {
+        if(Slot.Location >= 0 && Slot.Dirty) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// NOTE(Jovan): Expects the table's program to be bound
+internal void
+UploadUniforms(uniform_table *table) {
+    for(uniform_slot &Slot : table->Slots) {
+        if(!Slot.Dirty) {
+            continue;
+        }
+        if(Slot.Location >= 0) {
+            UploadUniformSlot(&Slot);
+            ++table->Uploads;
+        }
+        Slot.Dirty = false;
+    }
+    ++table->Frame;
+}
+
+// NOTE(Jovan): The inputs every fragment shader gets without asking
+struct standard_uniforms {
+    u32 Resolution;
+    u32 Time;
+    u32 Frame;
+    u32 Mouse;
+    u32 FragOffset;
+};
+
+internal standard_uniforms
+GetStandardUniforms(uniform_table *table) {
+    standard_uniforms Result;
+    Result.Resolution = GetUniformHandle(table, "Resolution");
+    Result.Time = GetUniformHandle(table, "Time");
+    Result.Frame = GetUniformHandle(table, "Frame");
+    Result.Mouse = GetUniformHandle(table, "Mouse");
+    Result.FragOffset = GetUniformHandle(table, "FragOffset");
+    return Result;
+}
@@ -0,0 +1,331 @@
+// NOTE(Jovan): Shader permutations. A shader declares its axes with
+// "#pragma variant", every axis gets just enough bits of a u32 key and the
+// built programs sit in a flat array indexed by that key, so switching
+// variants in the frame loop is a single lookup
+
+#define VARIANT_MAX_BITS 12
+#define VARIANT_PRECOMPILE_LIMIT 64
+
+struct variant_set {
+    shader_program Base;
+    std::vector<variant_axis> Axes;
+    u32 KeyBits;
+    u32 LastKey;
+    std::vector<shader_program> Programs;
+    std::vector<u32> PendingKeys;
+};
+
+internal b32
+IsNumber(const std::string &str) {
+    if(str.empty()) {
+        return false;
+    }
+    char *End = 0;
+    strtod(str.c_str(), &End);
+    return *End == '\0';
+}
+
+internal u32
+VariantValue(const variant_axis *axis, u32 key) {
+    return (key >> axis->Shift) & ((1u << axis->Bits) - 1);
+}
+
+internal b32
+IsValidVariantKey(const variant_set *set, u32 key) {
+    if(key >> set->KeyBits) {
+        return false;
+    }
+    for(const variant_axis &Axis : set->Axes) {
+        if(VariantValue(&Axis, key) >= Axis.Values.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+internal u32
+VariantCount(const variant_set *set) {
+    u32 Count = 1;
+    for(const variant_axis &Axis : set->Axes) {
+        Count *= (u32)Axis.Values.size();
+    }
+    return Count;
+}
+
+internal i32
+FindVariantAxis(const variant_set *set, const std::string &name) {
+    for(u32 AxisIndex = 0; AxisIndex < set->Axes.size(); ++AxisIndex) {
+        if(set->Axes[AxisIndex].Name == name) {
+            return (i32)AxisIndex;
+        }
+    }
+    return -1;
+}
+
+internal u32
+SetVariantValue(const variant_set *set, u32 key, const std::string &name, const std::string &value) {
+    i32 AxisIndex = FindVariantAxis(set, name);
+    if(AxisIndex < 0) {
+        return key;
+    }
+
+    const variant_axis *Axis = &set->Axes[AxisIndex];
+    for(u32 ValueIndex = 0; ValueIndex < Axis->Values.size(); ++ValueIndex) {
+        if(Axis->Values[ValueIndex] == value) {
+            u32 Mask = ((1u << Axis->Bits) - 1) << Axis->Shift;
+            return (key & ~Mask) | (ValueIndex << Axis->Shift);
+        }
+    }
+    return key;
+}
+
+internal u32
+CycleVariantAxis(const variant_set *set, u32 key, u32 axisIndex) {
+    if(axisIndex >= set->Axes.size()) {
+        return key;
+    }
+
+    const variant_axis *Axis = &set->Axes[axisIndex];
+    u32 Next = (VariantValue(Axis, key) + 1) % (u32)Axis->Values.size();
+    u32 Mask = ((1u << Axis->Bits) - 1) << Axis->Shift;
+    return (key & ~Mask) | (Next << Axis->Shift);
+}
+
+internal std::string
+VariantKeyName(const variant_set *set, u32 key) {
+    std::string Name;
+    for(const variant_axis &Axis : set->Axes) {
+        if(!Name.empty()) Name += " ";
+        Name += Axis.Name + "=" + Axis.Values[VariantValue(&Axis, key)];
+    }
+    return Name.empty() ? "default" : Name;
+}
+
+internal std::string
+VariantDefines(const variant_set *set, u32 key) {
+    std::string Defines;
+    for(const variant_axis &Axis : set->Axes) {
+        u32 Value = VariantValue(&Axis, key);
+        if(IsNumber(Axis.Values[Value])) {
+            Defines += "#define " + Axis.Name + " " + Axis.Values[Value] + "\n";
+        } else {
+            // NOTE(Jovan): Named values become constants so the shader can
+            // write "#if QUALITY == QUALITY_HIGH"
+            for(u32 ValueIndex = 0; ValueIndex < Axis.Values.size(); ++ValueIndex) {
+                Defines += "#define " + Axis.Name + "_" + Axis.Values[ValueIndex] + " " +
+                           std::to_string(ValueIndex) + "\n";
+            }
+            Defines += "#define " + Axis.Name + " " + std::to_string(Value) + "\n";
+        }
+    }
+    return Defines;
+}
+
+// NOTE(Jovan): Same values the defines get, for stages that come in as
+// SPIR-V and take the axes as specialization constants instead
+internal std::vector<source_knob>
+VariantKnobs(const variant_set *set, u32 key) {
+    std::vector<source_knob> Knobs;
+    for(const variant_axis &Axis : set->Axes) {
+        u32 Value = VariantValue(&Axis, key);
+        Knobs.push_back({Axis.Name, IsNumber(Axis.Values[Value]) ? Axis.Values[Value] : std::to_string(Value)});
+    }
+    return Knobs;
+}
+
+// NOTE(Jovan): Defines go right after #version, the #line keeps the error
+// line numbers of the root file intact
+internal preprocessed_source
+InjectVariantDefines(const preprocessed_source &source, const std::string &defines) {
+    preprocessed_source Result = source;
+    if(defines.empty()) {
+        return Result;
+    }
+
+    std::string Line = "#line " + std::to_string(source.VersionLine + 1) + " 0\n";
+    Result.Text = source.Text.substr(0, source.VersionEnd) + defines + Line + source.Text.substr(source.VersionEnd);
+    return Result;
+}
+
+internal void
+DeleteVariantPrograms(compile_queue *queue, variant_set *set) {
+    for(shader_program &Program : set->Programs) {
+        if(Program.PendingBuild) {
+            CancelCompileJob(queue, Program.PendingBuild);
+        }
+        DeleteShaderProgram(&Program);
+    }
+    set->Programs.clear();
+    set->PendingKeys.clear();
+}
+
+internal b32
+SameVariantAxes(const std::vector<variant_axis> &a, const std::vector<variant_axis> &b) {
+    if(a.size() != b.size()) {
+        return false;
+    }
+    for(size_t AxisIndex = 0; AxisIndex < a.size(); ++AxisIndex) {
+        if(a[AxisIndex].Name != b[AxisIndex].Name || a[AxisIndex].Values != b[AxisIndex].Values) {
+            return false;
+        }
+    }
+    return true;
+}
+
+internal u32
+LayoutVariantAxes(std::vector<variant_axis> &axes) {
+    u32 KeyBits = 0;
+    for(variant_axis &Axis : axes) {
+        Axis.Shift = KeyBits;
+        Axis.Bits = 0;
+        while((1u << Axis.Bits) < Axis.Values.size()) ++Axis.Bits;
+        KeyBits += Axis.Bits;
+    }
+    return KeyBits;
+}
+
+// NOTE(Jovan): Lays the axes out in the key. Built programs survive as long
+// as the axes didn't change, they keep drawing until their rebuild is done.
+// When they did, the one on screen moves to key 0 and stands in until that
+// key's build replaces it, so a new or broken axis never blanks the screen
+internal b32
+LayoutVariantSet(compile_queue *queue, variant_set *set) {
+    std::vector<variant_axis> Axes = set->Base.Vertex.Variants;
+    for(const variant_axis &Axis : set->Base.Fragment.Variants) {
+        b32 Known = false;
+        for(const variant_axis &Existing : Axes) {
+            Known |= Existing.Name == Axis.Name;
+        }
+        if(!Known) {
+            Axes.push_back(Axis);
+        }
+    }
+
+    u32 KeyBits = LayoutVariantAxes(Axes);
+    if(KeyBits > VARIANT_MAX_BITS) {
+        std::cerr << "[Err] Variants: " << set->Base.FragmentPath << " needs " << KeyBits
+                  << " key bits, at most " << VARIANT_MAX_BITS << " are supported" << std::endl;
+        return false;
+    }
+
+    if(!SameVariantAxes(Axes, set->Axes) || set->Programs.size() != (1u << KeyBits)) {
+        shader_program OnScreen = {};
+        if(set->LastKey < set->Programs.size()) {
+            std::swap(OnScreen, set->Programs[set->LastKey]);
+        }
+        DeleteVariantPrograms(queue, set);
+        set->Axes = Axes;
+        set->KeyBits = KeyBits;
+        set->LastKey = 0;
+        set->Programs.resize(1u << KeyBits);
+        std::swap(set->Programs[0], OnScreen);
+    }
+
+    for(shader_program &Program : set->Programs) {
+        Program.VertexPath = set->Base.VertexPath;
+        Program.FragmentPath = set->Base.FragmentPath;
+    }
+    return true;
+}
+
+internal void
+RequestVariantBuild(compile_queue *queue, variant_set *set, u32 key) {
+    shader_program *Program = &set->Programs[key];
+    std::string Defines = VariantDefines(set, key);
+    Program->Vertex = InjectVariantDefines(set->Base.Vertex, Defines);
+    Program->Fragment = InjectVariantDefines(set->Base.Fragment, Defines);
+    Program->Vertex.Knobs = Program->Fragment.Knobs = VariantKnobs(set, key);
+    RequestProgramBuild(queue, Program);
+
+    if(std::find(set->PendingKeys.begin(), set->PendingKeys.end(), key) == set->PendingKeys.end()) {
+        set->PendingKeys.push_back(key);
+    }
+}
+
+// NOTE(Jovan): The key that is on screen goes first, then everything that was
+// built before, or the whole set if it is small enough to precompile
+internal void
+RequestVariantSetBuild(compile_queue *queue, variant_set *set, u32 activeKey) {
+    if(!IsValidVariantKey(set, activeKey)) {
+        activeKey = 0;
+    }
+    RequestVariantBuild(queue, set, activeKey);
+
+    b32 Precompile = VariantCount(set) <= VARIANT_PRECOMPILE_LIMIT;
+    for(u32 Key = 0; Key < set->Programs.size(); ++Key) {
+        if(Key == activeKey || !IsValidVariantKey(set, Key)) {
+            continue;
+        }
+        if(Precompile || set->Programs[Key].ID || set->Programs[Key].PendingBuild) {
+            RequestVariantBuild(queue, set, Key);
+        }
+    }
+}
+
+internal b32
+LoadVariantSet(compile_queue *queue, shader_preprocessor *pp, variant_set *set,
+               const std::string &vertexPath, const std::string &fragmentPath, u32 activeKey) {
+    if(!ReadShaderProgram(pp, &set->Base, vertexPath, fragmentPath) ||
+       !LayoutVariantSet(queue, set)) {
+        return false;
+    }
+
+    RequestVariantSetBuild(queue, set, activeKey);
+    return true;
+}
+
+// NOTE(Jovan): A key that doesn't fit the new axes is moved to 0, which is
+// where the program on screen ends up when they changed
+internal b32
+ReloadVariantSet(compile_queue *queue, shader_preprocessor *pp, variant_set *set,
+                 const std::vector<std::string> &changed, u32 *activeKey) {
+    if(!ShaderProgramDependsOn(&set->Base, changed)) {
+        return false;
+    }
+
+    if(!PreprocessShaderProgram(pp, &set->Base) || !LayoutVariantSet(queue, set)) {
+        std::cerr << "[Err] Shader: Preprocessing " << set->Base.FragmentPath
+                  << " failed, keeping previous programs" << std::endl;
+        return false;
+    }
+
+    if(!IsValidVariantKey(set, *activeKey)) {
+        *activeKey = 0;
+    }
+    RequestVariantSetBuild(queue, set, *activeKey);
+    return true;
+}
+
+internal void
+UpdateVariantSet(compile_queue *queue, variant_set *set) {
+    for(size_t PendingIndex = 0; PendingIndex < set->PendingKeys.size();) {
+        shader_program *Program = &set->Programs[set->PendingKeys[PendingIndex]];
+        UpdateProgramBuild(queue, Program);
+        if(Program->PendingBuild) {
+            ++PendingIndex;
+        } else {
+            set->PendingKeys.erase(set->PendingKeys.begin() + PendingIndex);
+        }
+    }
+}
+
+// NOTE(Jovan): Variants that aren't built yet are kicked off in the
+// background, until then the last variant that was on screen stands in. So
+// does it for a key the current axes don't have
+internal u32
+GetVariantProgram(compile_queue *queue, variant_set *set, u32 key) {
+    if(key >= set->Programs.size()) {
+        return set->LastKey < set->Programs.size() ? set->Programs[set->LastKey].ID : 0;
+    }
+
+    shader_program *Program = &set->Programs[key];
+    if(Program->ID) {
+        set->LastKey = key;
+        return Program->ID;
+    }
+
+    if(!Program->PendingBuild && IsValidVariantKey(set, key)) {
+        RequestVariantBuild(queue, set, key);
+    }
+    return set->Programs[set->LastKey].ID;
+}
@@ -0,0 +1,206 @@
+// NOTE(Jovan): inotify based file watcher. A background thread waits for
+// saves, reads the changed files and queues them up for the render thread
+// which only has to pick up the already loaded contents between frames
+
+#define WATCHER_SETTLE_MS 30
+
+struct file_change {
+    std::string Path;
+    std::string Contents;
+};
+
+struct watched_dir {
+    i32 WD;
+    std::string Path;
+};
+
+struct watched_file {
+    i32 WD;
+    std::string Name;
+    std::string Path;
+};
+
+struct file_watcher {
+    i32 INotifyFD;
+    i32 WakePipe[2];
+    std::thread Thread;
+    std::mutex Mutex;
+    std::vector<watched_dir> Dirs;
+    std::vector<watched_file> Files;
+    std::vector<file_change> Changes;
+    std::atomic<b32> Running;
+    main_thread_wake *WakeMainThread;
+};
+
+internal b32
+WatchFile(file_watcher *watcher, const std::string &path) {
+    if(watcher->INotifyFD < 0) {
+        return false;
+    }
+
+    std::string Dir, Name;
+    SplitPath(path, Dir, Name);
+
+    std::lock_guard<std::mutex> Lock(watcher->Mutex);
+    for(const watched_file &File : watcher->Files) {
+        if(File.Path == path) {
+            return true;
+        }
+    }
+
+    // NOTE(Jovan): Watch the directory instead of the file, editors like vim
+    // write a new file and rename it over the old one which would kill a
+    // watch placed on the file itself
+    i32 WD = inotify_add_watch(watcher->INotifyFD, Dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if(WD < 0) {
+        std::cerr << "[Err] Watcher: Failed watching " << Dir << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    b32 KnownDir = false;
+    for(const watched_dir &Watched : watcher->Dirs) {
+        if(Watched.WD == WD) {
+            KnownDir = true;
+            break;
+        }
+    }
+    if(!KnownDir) {
+        watcher->Dirs.push_back({WD, Dir});
+    }
+
+    watcher->Files.push_back({WD, Name, path});
+    return true;
+}
+
+internal void
+_WatcherThread(file_watcher *watcher) {
+    alignas(struct inotify_event) char Buffer[4096];
+    pollfd FDs[2] = {
+        {watcher->INotifyFD, POLLIN, 0},
+        {watcher->WakePipe[0], POLLIN, 0},
+    };
+
+    std::vector<std::string> Pending;
+    while(watcher->Running) {
+        // NOTE(Jovan): Block until something happens, then keep draining with a
+        // short timeout so a burst of events from a single save is coalesced
+        i32 Timeout = Pending.empty() ? -1 : WATCHER_SETTLE_MS;
+        i32 Ready = poll(FDs, 2, Timeout);
+        if(Ready < 0) {
+            if(errno == EINTR) continue;
+            std::cerr << "[Err] Watcher: poll failed: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        if(FDs[1].revents & POLLIN) {
+            break;
+        }
+
+        if(Ready == 0) {
+            std::vector<file_change> Loaded;
+            for(const std::string &Path : Pending) {
+                file_change Change;
+                Change.Path = Path;
+                if(ReadEntireFile(Path, Change.Contents)) {
+                    Loaded.push_back(std::move(Change));
+                }
+            }
+            Pending.clear();
+
+            if(Loaded.empty()) {
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> Lock(watcher->Mutex);
+                for(file_change &Change : Loaded) {
+                    watcher->Changes.push_back(std::move(Change));
+                }
+            }
+            if(watcher->WakeMainThread) {
+                watcher->WakeMainThread();
+            }
+            continue;
+        }
+
+        ssize_t Length = read(watcher->INotifyFD, Buffer, sizeof(Buffer));
+        if(Length <= 0) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> Lock(watcher->Mutex);
+        for(char *At = Buffer; At < Buffer + Length;) {
+            struct inotify_event *Event = (struct inotify_event*)At;
+            At += sizeof(struct inotify_event) + Event->len;
+            if(!Event->len) {
+                continue;
+            }
+
+            for(const watched_file &File : watcher->Files) {
+                if(File.WD == Event->wd && File.Name == Event->name) {
+                    if(std::find(Pending.begin(), Pending.end(), File.Path) == Pending.end()) {
+                        Pending.push_back(File.Path);
+                    }
+                }
+            }
+        }
+    }
+}
+
+internal b32
+InitFileWatcher(file_watcher *watcher, main_thread_wake *wake = 0) {
+    watcher->Running = false;
+    watcher->WakeMainThread = wake;
+    watcher->WakePipe[0] = watcher->WakePipe[1] = -1;
+    watcher->INotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(watcher->INotifyFD < 0) {
+        std::cerr << "[Err] Watcher: inotify_init1 failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    if(pipe2(watcher->WakePipe, O_CLOEXEC) < 0) {
+        std::cerr << "[Err] Watcher: pipe2 failed: " << strerror(errno) << std::endl;
+        close(watcher->INotifyFD);
+        watcher->INotifyFD = -1;
+        return false;
+    }
+
+    watcher->Running = true;
+    watcher->Thread = std::thread(_WatcherThread, watcher);
+    return true;
+}
+
+internal std::vector<file_change>
+PollFileChanges(file_watcher *watcher) {
+    std::vector<file_change> Changes;
+    std::lock_guard<std::mutex> Lock(watcher->Mutex);
+    Changes.swap(watcher->Changes);
+    return Changes;
+}
+
+internal void
+ShutdownFileWatcher(file_watcher *watcher) {
+    if(watcher->Running) {
+        watcher->Running = false;
+        char Wake = 1;
+        if(write(watcher->WakePipe[1], &Wake, 1) < 0) {
+            std::cerr << "[Err] Watcher: Failed waking watcher thread" << std::endl;
+        }
+        watcher->Thread.join();
+    }
+
+    if(watcher->INotifyFD >= 0) close(watcher->INotifyFD);
+    if(watcher->WakePipe[0] >= 0) close(watcher->WakePipe[0]);
+    if(watcher->WakePipe[1] >= 0) close(watcher->WakePipe[1]);
+    watcher->INotifyFD = -1;
+    watcher->WakePipe[0] = watcher->WakePipe[1] = -1;
+}
+
+internal void
+WatchShaderProgram(file_watcher *watcher, const shader_program *program) {
+    for(const std::string &Path : program->Vertex.Files) {
+        WatchFile(watcher, Path);
+    }
+    for(const std::string &Path : program->Fragment.Files) {
+        WatchFile(watcher, Path);
+    }
+}
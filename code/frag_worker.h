@@ -0,0 +1,159 @@
+// NOTE(Jovan): Background compile worker. Owns a second context that shares
+// objects with the window's, compiles and links there and draws every new
+// program once into a 1x1 target. Lots of drivers only finish the real
+// compile on first use, the warm-up draw makes sure that happens here and
+// not in the middle of a frame. A fence marks when the program is ready
+
+typedef void worker_make_current(void *context);
+// NOTE(Jovan): Lets a background thread wake the frame loop while it's
+// waiting for events
+typedef void main_thread_wake(void);
+
+struct worker_job {
+    u32 Handle;
+    shader_program Program;
+    GLsync Fence;
+};
+
+struct compile_worker {
+    void *Context;
+    worker_make_current *MakeCurrent;
+    main_thread_wake *WakeMainThread;
+    std::thread Thread;
+    std::mutex Mutex;
+    std::condition_variable Wake;
+    std::vector<worker_job> Requests;
+    std::vector<worker_job> Finished;
+    b32 Running;
+};
+
+internal void
+WarmUpProgram(u32 programID, u32 framebuffer, u32 vao) {
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, 1, 1);
+    glUseProgram(programID);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glUseProgram(0);
+}
+
+internal void
+_CompileWorkerThread(compile_worker *worker) {
+    worker->MakeCurrent(worker->Context);
+
+    // NOTE(Jovan): Framebuffers and VAOs aren't shared between contexts, the
+    // worker keeps its own
+    u32 Texture, Framebuffer, VAO;
+    glGenTextures(1, &Texture);
+    glBindTexture(GL_TEXTURE_2D, Texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glGenFramebuffers(1, &Framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Texture, 0);
+    glGenVertexArrays(1, &VAO);
+
+    for(;;) {
+        worker_job Job;
+        {
+            std::unique_lock<std::mutex> Lock(worker->Mutex);
+            worker->Wake.wait(Lock, [worker] { return !worker->Running || !worker->Requests.empty(); });
+            if(!worker->Running) {
+                break;
+            }
+            Job = std::move(worker->Requests.front());
+            worker->Requests.erase(worker->Requests.begin());
+        }
+
+        Job.Program.ID = BuildProgram(&Job.Program);
+        Job.Fence = 0;
+        if(Job.Program.ID) {
+            WarmUpProgram(Job.Program.ID, Framebuffer, VAO);
+            Job.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        glFlush();
+
+        {
+            std::lock_guard<std::mutex> Lock(worker->Mutex);
+            worker->Finished.push_back(std::move(Job));
+        }
+        if(worker->WakeMainThread) {
+            worker->WakeMainThread();
+        }
+    }
+
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteFramebuffers(1, &Framebuffer);
+    glDeleteTextures(1, &Texture);
+    glFinish();
+    worker->MakeCurrent(0);
+}
+
+// NOTE(Jovan): The context has to be created on the main thread next to the
+// window, the worker only ever makes it current on its own thread
+internal void
+InitCompileWorker(compile_worker *worker, void *context, worker_make_current *makeCurrent,
+                  main_thread_wake *wake = 0) {
+    worker->Context = context;
+    worker->MakeCurrent = makeCurrent;
+    worker->WakeMainThread = wake;
+    worker->Running = true;
+    worker->Thread = std::thread(_CompileWorkerThread, worker);
+}
+
+internal void
+PushWorkerJob(compile_worker *worker, u32 handle, const shader_program *program) {
+    worker_job Job;
+    Job.Handle = handle;
+    Job.Program = *program;
+    Job.Program.ID = 0;
+    Job.Program.PendingBuild = 0;
+    Job.Fence = 0;
+    {
+        std::lock_guard<std::mutex> Lock(worker->Mutex);
+        worker->Requests.push_back(std::move(Job));
+    }
+    worker->Wake.notify_one();
+}
+
+// NOTE(Jovan): Drops a job that hasn't been picked up yet, returns false if
+// the worker is already on it
+internal b32
+RemoveWorkerJob(compile_worker *worker, u32 handle) {
+    std::lock_guard<std::mutex> Lock(worker->Mutex);
+    for(size_t JobIndex = 0; JobIndex < worker->Requests.size(); ++JobIndex) {
+        if(worker->Requests[JobIndex].Handle == handle) {
+            worker->Requests.erase(worker->Requests.begin() + JobIndex);
+            return true;
+        }
+    }
+    return false;
+}
+
+internal std::vector<worker_job>
+PollWorkerJobs(compile_worker *worker) {
+    std::vector<worker_job> Finished;
+    std::lock_guard<std::mutex> Lock(worker->Mutex);
+    Finished.swap(worker->Finished);
+    return Finished;
+}
+
+internal void
+ShutdownCompileWorker(compile_worker *worker) {
+    if(!worker->Running) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock(worker->Mutex);
+        worker->Running = false;
+        worker->Requests.clear();
+    }
+    worker->Wake.notify_one();
+    worker->Thread.join();
+
+    for(worker_job &Job : worker->Finished) {
+        if(Job.Fence) glDeleteSync(Job.Fence);
+        if(Job.Program.ID) glDeleteProgram(Job.Program.ID);
+    }
+    worker->Finished.clear();
+}
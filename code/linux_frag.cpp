@@ -2,8 +2,29 @@
 #include <cstdint>
 #include "include/glad/glad.h"
 #include <GLFW/glfw3.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <fstream>
 #include <streambuf>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <unordered_map>
+#include <cstring>
+#include <cmath>
+#include <cerrno>
+#include <chrono>
+#include <ctime>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
 
 #define global static
 #define internal static
@@ -24,6 +45,14 @@ typedef u32 b32;
 
 global i32 G_WWIDTH = 800;
 global i32 G_WHEIGHT = 600;
+global i32 G_CYCLE_AXIS = -1;
+global b32 G_TOGGLE_SPECIALIZE = false;
+global b32 G_TOGGLE_HEATMAP = false;
+global b32 G_TOGGLE_PROFILER = false;
+global b32 G_TOGGLE_ACCUMULATE = false;
+global b32 G_TOGGLE_DYNRES = false;
+global b32 G_TOGGLE_CHECKERBOARD = false;
+global b32 G_REDRAW = false;
 
 internal void
 _ErrorCallback(int error, const char* description) {
@@ -32,42 +61,300 @@ _ErrorCallback(int error, const char* description) {
 
 internal void
 _KeyCallback(GLFWwindow *window, i32 key, i32 scode, i32 action, i32 mods) {
+    if(action == GLFW_PRESS) {
+        G_REDRAW = true;
+    }
     if(key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, GLFW_TRUE);
     }
+    // NOTE(Jovan): Number keys cycle through the values of the matching variant axis
+    if(key >= GLFW_KEY_1 && key <= GLFW_KEY_9 && action == GLFW_PRESS) {
+        G_CYCLE_AXIS = key - GLFW_KEY_1;
+    }
+    if(key == GLFW_KEY_S && action == GLFW_PRESS) {
+        G_TOGGLE_SPECIALIZE = true;
+    }
+    if(key == GLFW_KEY_H && action == GLFW_PRESS) {
+        G_TOGGLE_HEATMAP = true;
+    }
+    if(key == GLFW_KEY_P && action == GLFW_PRESS) {
+        G_TOGGLE_PROFILER = true;
+    }
+    if(key == GLFW_KEY_A && action == GLFW_PRESS) {
+        G_TOGGLE_ACCUMULATE = true;
+    }
+    if(key == GLFW_KEY_R && action == GLFW_PRESS) {
+        G_TOGGLE_DYNRES = true;
+    }
+    if(key == GLFW_KEY_C && action == GLFW_PRESS) {
+        G_TOGGLE_CHECKERBOARD = true;
+    }
 }
 
-internal u32
-LoadAndCompileShader(std::string filename, GLuint shaderType) {
-    u32 ShaderID = 0;
-    std::ifstream In(filename);
-    std::string Str;
+internal void
+_RefreshCallback(GLFWwindow*) {
+    G_REDRAW = true;
+}
+
+internal void
+_MakeGLFWContextCurrent(void *context) {
+    glfwMakeContextCurrent((GLFWwindow*)context);
+}
+
+// NOTE(Jovan): Safe from any thread, gets glfwWaitEvents to return
+internal void
+_WakeMainThread() {
+    glfwPostEmptyEvent();
+}
+
+internal b32
+ReadEntireFile(const std::string &path, std::string &out) {
+    std::ifstream In(path, std::ios::in | std::ios::binary);
+    if(!In) {
+        return false;
+    }
 
     In.seekg(0, std::ios::end);
-    Str.reserve(In.tellg());
+    std::streamoff Size = In.tellg();
     In.seekg(0, std::ios::beg);
+    if(Size < 0) {
+        return false;
+    }
+
+    out.resize((size_t)Size);
+    if(Size > 0) {
+        In.read(&out[0], Size);
+        out.resize((size_t)In.gcount());
+    }
+    return true;
+}
 
-    Str.assign((std::istreambuf_iterator<char>(In)), std::istreambuf_iterator<char>());
-    const char *CharContent = Str.c_str();
+internal b32
+MakeDirectories(const std::string &path) {
+    for(size_t Slash = path.find('/', 1); ; Slash = path.find('/', Slash + 1)) {
+        std::string Part = path.substr(0, Slash);
+        if(mkdir(Part.c_str(), 0755) < 0 && errno != EEXIST) {
+            return false;
+        }
+        if(Slash == std::string::npos) {
+            return true;
+        }
+    }
+}
 
-    ShaderID = glCreateShader(shaderType);
-    glShaderSource(ShaderID, 1, &CharContent, NULL);
-    glCompileShader(ShaderID);
+internal void
+SplitPath(const std::string &path, std::string &dir, std::string &name) {
+    size_t Slash = path.find_last_of('/');
+    if(Slash == std::string::npos) {
+        dir = ".";
+        name = path;
+    } else {
+        dir = Slash == 0 ? "/" : path.substr(0, Slash);
+        name = path.substr(Slash + 1);
+    }
+}
 
-    int Success;
-    char InfoLog[512];
-    glGetShaderiv(ShaderID, GL_COMPILE_STATUS, &Success);
-    if (!Success) {
-        glGetShaderInfoLog(ShaderID, 256, NULL, InfoLog);
-        std::cout << "Error while compiling shader:" << std::endl << InfoLog << std::endl;
-        return 0;
+internal b32
+ListFiles(const std::string &dir, std::vector<std::string> &out) {
+    DIR *Dir = opendir(dir.c_str());
+    if(!Dir) {
+        return false;
     }
 
-    return ShaderID;
+    while(struct dirent *Entry = readdir(Dir)) {
+        std::string Name = Entry->d_name;
+        if(Name == "." || Name == "..") {
+            continue;
+        }
+
+        std::string Path = dir + "/" + Name;
+        struct stat Stat;
+        if(stat(Path.c_str(), &Stat) < 0) {
+            continue;
+        }
+        if(S_ISDIR(Stat.st_mode)) {
+            ListFiles(Path, out);
+        } else if(S_ISREG(Stat.st_mode)) {
+            out.push_back(Path);
+        }
+    }
+    closedir(Dir);
+    return true;
 }
 
+// NOTE(Jovan): Purely lexical, collapses "." and "dir/.." so the same file
+// reached through different includes ends up with a single name
+internal std::string
+NormalizePath(const std::string &path) {
+    std::vector<std::string> Parts;
+    b32 Absolute = !path.empty() && path[0] == '/';
+    size_t Start = 0;
+    while(Start <= path.size()) {
+        size_t Slash = path.find('/', Start);
+        if(Slash == std::string::npos) Slash = path.size();
+        std::string Part = path.substr(Start, Slash - Start);
+        if(Part == "..") {
+            if(!Parts.empty() && Parts.back() != "..") {
+                Parts.pop_back();
+            } else if(!Absolute) {
+                Parts.push_back(Part);
+            }
+        } else if(!Part.empty() && Part != ".") {
+            Parts.push_back(Part);
+        }
+        Start = Slash + 1;
+    }
+
+    std::string Result = Absolute ? "/" : "";
+    for(size_t PartIndex = 0; PartIndex < Parts.size(); ++PartIndex) {
+        if(PartIndex) Result += "/";
+        Result += Parts[PartIndex];
+    }
+    return Result.empty() ? "." : Result;
+}
+
+#include "frag_cache.h"
+#include "frag_preprocessor.h"
+#include "frag_spirv.h"
+#include "frag_shader.h"
+#include "frag_worker.h"
+#include "frag_async.h"
+#include "frag_variants.h"
+#include "frag_uniforms.h"
+#include "frag_egl.h"
+#include "frag_batch.h"
+#include "frag_readback.h"
+#include "frag_cost.h"
+#include "frag_specialize.h"
+#include "frag_heatmap.h"
+#include "frag_accumulate.h"
+#include "frag_dynres.h"
+#include "frag_checkerboard.h"
+#include "frag_bench.h"
+#include "frag_pacing.h"
+#include "frag_profiler.h"
+#include "frag_graph.h"
+#include "frag_headless.h"
+#include "frag_watcher.h"
+
 i32
-main() {
+main(i32 argc, char **argv) {
+    std::string VertexPath = "../shaders/frag.vert";
+    std::string FragmentPath = "../shaders/frag.frag";
+    std::string CompileOnlyDir;
+    std::string GraphPath;
+    std::vector<std::string> CostPaths;
+    std::string SpirvSourcePath;
+    u32 ThreadCount = 0;
+    b32 Specialize = false;
+    b32 Bench = true;
+    b32 Profile = false;
+    b32 Accumulate = false;
+    u32 AccumulateSamples = ACCUMULATE_DEFAULT_SAMPLES;
+    r64 AccumulateNoise = ACCUMULATE_DEFAULT_NOISE;
+    b32 DynamicScale = false;
+    r64 FrameBudgetMs = DYNRES_DEFAULT_BUDGET_MS;
+    b32 Checkerboard = false;
+    u32 CheckerBlock = CHECKER_DEFAULT_BLOCK;
+    pacing_mode Pacing = Pacing_Vsync;
+    r64 TargetFPS = 0.0;
+    b32 Headless = false;
+    headless_options HeadlessOptions = {};
+    HeadlessOptions.Frames = 1;
+    HeadlessOptions.Timestep = 1.0 / 60.0;
+    HeadlessOptions.ReadbackSlots = READBACK_DEFAULT_SLOTS;
+    HeadlessOptions.TileBudgetMs = TILE_DEFAULT_BUDGET_MS;
+    for(i32 ArgIndex = 1; ArgIndex < argc; ++ArgIndex) {
+        std::string Arg = argv[ArgIndex];
+        if(Arg == "--compile-only" && ArgIndex + 1 < argc) {
+            CompileOnlyDir = argv[++ArgIndex];
+        } else if(Arg == "--cost" && ArgIndex + 1 < argc) {
+            CostPaths.push_back(argv[++ArgIndex]);
+        } else if(Arg == "--spirv-source" && ArgIndex + 1 < argc) {
+            SpirvSourcePath = argv[++ArgIndex];
+        } else if(Arg == "--specialize") {
+            Specialize = true;
+        } else if(Arg == "--no-bench") {
+            Bench = false;
+        } else if(Arg == "--profile") {
+            Profile = true;
+        } else if(Arg == "--dynres" && ArgIndex + 1 < argc) {
+            DynamicScale = true;
+            FrameBudgetMs = atof(argv[++ArgIndex]);
+        } else if(Arg == "--checkerboard") {
+            Checkerboard = true;
+        } else if(Arg == "--checker-block" && ArgIndex + 1 < argc) {
+            CheckerBlock = (u32)atoi(argv[++ArgIndex]);
+        } else if(Arg == "--accumulate") {
+            Accumulate = true;
+        } else if(Arg == "--samples" && ArgIndex + 1 < argc) {
+            AccumulateSamples = (u32)atoi(argv[++ArgIndex]);
+        } else if(Arg == "--noise" && ArgIndex + 1 < argc) {
+            AccumulateNoise = atof(argv[++ArgIndex]);
+        } else if(Arg == "--pacing" && ArgIndex + 1 < argc) {
+            if(!ParsePacingMode(argv[++ArgIndex], &Pacing)) {
+                std::cerr << "[Err] Pacing: Unknown mode " << argv[ArgIndex]
+                          << ", expected vsync, adaptive, uncapped or fixed" << std::endl;
+                return -1;
+            }
+        } else if(Arg == "--fps" && ArgIndex + 1 < argc) {
+            Pacing = Pacing_Fixed;
+            TargetFPS = atof(argv[++ArgIndex]);
+        } else if(Arg == "--headless" && ArgIndex + 1 < argc) {
+            Headless = true;
+            if(!ParseResolution(argv[++ArgIndex], &HeadlessOptions.Width, &HeadlessOptions.Height)) {
+                std::cerr << "[Err] Headless: Expected a resolution like 1920x1080, got " << argv[ArgIndex] << std::endl;
+                return -1;
+            }
+        } else if(Arg == "--frames" && ArgIndex + 1 < argc) {
+            HeadlessOptions.Frames = (u32)atoi(argv[++ArgIndex]);
+        } else if(Arg == "--timestep" && ArgIndex + 1 < argc) {
+            HeadlessOptions.Timestep = atof(argv[++ArgIndex]);
+        } else if(Arg == "--output" && ArgIndex + 1 < argc) {
+            HeadlessOptions.OutputPath = argv[++ArgIndex];
+            std::string Expanded;
+            i32 Numbers = ExpandFramePath(HeadlessOptions.OutputPath, 0, &Expanded);
+            if(Numbers < 0 || Numbers > 1) {
+                std::cerr << "[Err] Headless: --output takes at most one %d or %u for the frame number and %% "
+                          << "for a percent sign, got " << HeadlessOptions.OutputPath << std::endl;
+                return -1;
+            }
+        } else if(Arg == "--tiled") {
+            HeadlessOptions.Tiled = true;
+        } else if(Arg == "--tile-budget" && ArgIndex + 1 < argc) {
+            HeadlessOptions.TileBudgetMs = atof(argv[++ArgIndex]);
+        } else if(Arg == "--readback") {
+            HeadlessOptions.ReadbackAll = true;
+        } else if(Arg == "--readback-slots" && ArgIndex + 1 < argc) {
+            HeadlessOptions.ReadbackSlots = (u32)atoi(argv[++ArgIndex]);
+        } else if(Arg == "--graph" && ArgIndex + 1 < argc) {
+            GraphPath = argv[++ArgIndex];
+        } else if(Arg == "--threads" && ArgIndex + 1 < argc) {
+            ThreadCount = (u32)atoi(argv[++ArgIndex]);
+        } else {
+            FragmentPath = Arg;
+        }
+    }
+
+    if(!CostPaths.empty()) {
+        return PrintShaderCosts(CostPaths, {"../shaders/include"});
+    }
+    if(!SpirvSourcePath.empty()) {
+        return PrintSpirvSource(SpirvSourcePath, {"../shaders/include"});
+    }
+    if(!CompileOnlyDir.empty()) {
+        return CompileOnly(CompileOnlyDir, ThreadCount);
+    }
+    if(Headless) {
+        if(!GraphPath.empty()) {
+            std::cerr << "[Err] Graph: Headless renders don't run graphs" << std::endl;
+            return -1;
+        }
+        HeadlessOptions.VertexPath = VertexPath;
+        HeadlessOptions.FragmentPath = FragmentPath;
+        HeadlessOptions.Profile = Profile;
+        return RenderHeadless(&HeadlessOptions);
+    }
 
     std::cout << "Hello" << std::endl;
     if(!glfwInit()) {
@@ -78,6 +365,7 @@ main() {
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     GLFWwindow *Window = glfwCreateWindow(G_WWIDTH, G_WHEIGHT, "Frag!", 0, 0);
     if(!Window) {
         std::cerr << "[Err] GLFW: Failed creating window" << std::endl;
@@ -85,25 +373,347 @@ main() {
         return -1;
     }
     glfwSetKeyCallback(Window, _KeyCallback);
+    glfwSetWindowRefreshCallback(Window, _RefreshCallback);
     glfwMakeContextCurrent(Window);
     gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
-    glfwSwapInterval(1);
+    frame_pacer Pacer = {};
+    InitFramePacer(&Pacer, Pacing, TargetFPS);
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
+    InitProgramCache(&G_PROGRAM_CACHE, DefaultProgramCacheDir());
+
+    // NOTE(Jovan): Hidden 1x1 window whose context shares objects with the
+    // main one, programs get built on it in the background
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *WorkerWindow = glfwCreateWindow(1, 1, "Frag worker", 0, Window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+    compile_worker Worker;
+    compile_queue CompileQueue;
+    if(WorkerWindow) {
+        InitCompileWorker(&Worker, WorkerWindow, _MakeGLFWContextCurrent, _WakeMainThread);
+        InitCompileQueue(&CompileQueue, &Worker);
+    } else {
+        std::cerr << "[Err] GLFW: Failed creating the worker context, compiling on the main thread" << std::endl;
+        InitCompileQueue(&CompileQueue);
+    }
+
+    shader_preprocessor Preprocessor;
+    Preprocessor.IncludeDirs.push_back("../shaders/include");
+
+    // NOTE(Jovan): With a graph the image pass is the shader the loop draws,
+    // the buffer passes run right before it
+    render_graph Graph = {};
+    b32 UseGraph = false;
+    if(!GraphPath.empty()) {
+        UseGraph = LoadRenderGraph(&CompileQueue, &Preprocessor, &Graph, GraphPath, VertexPath);
+        if(UseGraph) {
+            FragmentPath = Graph.Image.FragmentPath;
+        } else {
+            std::cerr << "[Err] Graph: Falling back to " << FragmentPath << std::endl;
+            ShutdownRenderGraph(&CompileQueue, &Graph);
+            Graph = {};
+        }
+    }
+
+    variant_set Shader = {};
+    u32 VariantKey = 0;
+    LoadVariantSet(&CompileQueue, &Preprocessor, &Shader, VertexPath, FragmentPath, VariantKey);
+
+    file_watcher Watcher;
+    if(InitFileWatcher(&Watcher, _WakeMainThread)) {
+        WatchFile(&Watcher, Shader.Base.VertexPath);
+        WatchFile(&Watcher, Shader.Base.FragmentPath);
+        WatchShaderProgram(&Watcher, &Shader.Base);
+        for(u32 PassIndex : Graph.Order) {
+            WatchShaderProgram(&Watcher, &Graph.Passes[PassIndex].Shader.Base);
+        }
+    }
+
+    uniform_table Uniforms = {};
+    standard_uniforms Inputs = GetStandardUniforms(&Uniforms);
+    if(UseGraph) {
+        GetGraphChannelUniforms(&Graph.Image, &Uniforms);
+    }
+    uniform_specializer Specializer = {};
+    Specializer.Enabled = Specialize;
+    heatmap_view Heatmap = {};
+    InitHeatmap(&Heatmap);
+    bench_state Benchmark = {};
+    Benchmark.Enabled = Bench;
+    InitBench(&Benchmark);
+    gpu_profiler Profiler = {};
+    Profiler.Enabled = Profile;
+    InitGpuProfiler(&Profiler);
+    accumulator Accumulator = {};
+    Accumulator.Enabled = Accumulate;
+    Accumulator.TargetSamples = AccumulateSamples;
+    Accumulator.NoiseThreshold = AccumulateNoise;
+    InitAccumulator(&Accumulator);
+    dynamic_resolution DynamicResolution = {};
+    DynamicResolution.Enabled = DynamicScale;
+    DynamicResolution.BudgetMs = FrameBudgetMs;
+    InitDynamicResolution(&DynamicResolution);
+    checkerboard_renderer Checker = {};
+    Checker.Enabled = Checkerboard;
+    Checker.BlockSize = CheckerBlock;
+    InitCheckerboard(&Checker);
+
+    // NOTE(Jovan): Core profile needs a bound VAO even though the vertices
+    // come from gl_VertexID
+    u32 VAO;
+    glGenVertexArrays(1, &VAO);
+    r64 StartTime = glfwGetTime();
+    u32 FrameIndex = 0;
+    // NOTE(Jovan): Programs that don't read Time or Frame look the same frame
+    // after frame, for those the loop sleeps in glfwWaitEvents and only
+    // draws again once something they read, the program or the size changes
+    b32 Animating = true;
+    u32 DrawnProgramID = 0;
+    i32 DrawnWidth = 0, DrawnHeight = 0;
+
     while(!glfwWindowShouldClose(Window)) {
+        std::vector<file_change> Changes = PollFileChanges(&Watcher);
+        if(!Changes.empty()) {
+            std::vector<std::string> Changed;
+            for(file_change &Change : Changes) {
+                UpdateSourceFile(&Preprocessor, Change.Path, Change.Contents);
+                for(std::string &Dependent : CollectDependents(&Preprocessor, Change.Path)) {
+                    Changed.push_back(Dependent);
+                }
+            }
+
+            if(ReloadVariantSet(&CompileQueue, &Preprocessor, &Shader, Changed, &VariantKey)) {
+                WatchShaderProgram(&Watcher, &Shader.Base);
+            }
+            if(ReloadRenderGraph(&CompileQueue, &Preprocessor, &Graph, Changed)) {
+                for(u32 PassIndex : Graph.Order) {
+                    WatchShaderProgram(&Watcher, &Graph.Passes[PassIndex].Shader.Base);
+                }
+            }
+        }
+        UpdateCompileQueue(&CompileQueue);
+        UpdateVariantSet(&CompileQueue, &Shader);
+        UpdateRenderGraph(&CompileQueue, &Graph);
+
+        if(G_CYCLE_AXIS >= 0) {
+            u32 NextKey = CycleVariantAxis(&Shader, VariantKey, G_CYCLE_AXIS);
+            if(NextKey != VariantKey) {
+                VariantKey = NextKey;
+                std::cout << "[Info] Variants: " << VariantKeyName(&Shader, VariantKey) << std::endl;
+            }
+            G_CYCLE_AXIS = -1;
+        }
+        if(G_TOGGLE_SPECIALIZE) {
+            Specializer.Enabled = !Specializer.Enabled;
+            std::cout << "[Info] Specialize: " << (Specializer.Enabled ? "On" : "Off") << std::endl;
+            G_TOGGLE_SPECIALIZE = false;
+        }
+        if(G_TOGGLE_HEATMAP) {
+            Heatmap.Enabled = !Heatmap.Enabled;
+            std::cout << "[Info] Heatmap: " << (Heatmap.Enabled ? "On" : "Off") << std::endl;
+            G_TOGGLE_HEATMAP = false;
+        }
+        if(G_TOGGLE_PROFILER) {
+            Profiler.Enabled = !Profiler.Enabled;
+            std::cout << "[Info] Profiler: " << (Profiler.Enabled ? "On" : "Off") << std::endl;
+            if(!Profiler.Enabled) {
+                PrintGpuProfile(&Profiler);
+            }
+            G_TOGGLE_PROFILER = false;
+        }
+        if(G_TOGGLE_ACCUMULATE) {
+            Accumulator.Enabled = !Accumulator.Enabled;
+            ResetAccumulation(&Accumulator);
+            std::cout << "[Info] Accumulate: " << (Accumulator.Enabled ? "On" : "Off") << std::endl;
+            G_TOGGLE_ACCUMULATE = false;
+        }
+        if(G_TOGGLE_DYNRES) {
+            DynamicResolution.Enabled = !DynamicResolution.Enabled;
+            std::cout << "[Info] Dynamic resolution: " << (DynamicResolution.Enabled ? "On" : "Off") << std::endl;
+            G_TOGGLE_DYNRES = false;
+        }
+        if(G_TOGGLE_CHECKERBOARD) {
+            Checker.Enabled = !Checker.Enabled;
+            std::cout << "[Info] Checkerboard: " << (Checker.Enabled ? "On" : "Off") << std::endl;
+            G_TOGGLE_CHECKERBOARD = false;
+        }
+
         glfwGetFramebufferSize(Window, &G_WWIDTH, &G_WHEIGHT);
         r32 AspectRatio = G_WWIDTH / (float) G_WHEIGHT;
         glViewport(0, 0, G_WWIDTH, G_WHEIGHT);
+        // NOTE(Jovan): Accumulation and the heatmap want every pixel as is,
+        // checkerboarding already is the cheaper mode when both are on
+        b32 Checkering = Checker.Enabled && !Accumulator.Enabled && !Heatmap.Enabled;
+        b32 Scaling = DynamicResolution.Enabled && !Checkering && !Accumulator.Enabled && !Heatmap.Enabled;
+        i32 RenderWidth = G_WWIDTH, RenderHeight = G_WHEIGHT;
+        if(Scaling) {
+            BeginDynamicResolution(&DynamicResolution, G_WWIDTH, G_WHEIGHT);
+            RenderWidth = DynamicResolution.RenderWidth;
+            RenderHeight = DynamicResolution.RenderHeight;
+        }
+        SetUniform2f(&Uniforms, Inputs.Resolution, (r32)RenderWidth, (r32)RenderHeight);
+        // NOTE(Jovan): Accumulation holds time still, otherwise it would start
+        // over every frame
+        r32 Now = (r32)(glfwGetTime() - StartTime);
+        if(!Accumulator.Enabled) {
+            SetUniform1f(&Uniforms, Inputs.Time, Now);
+        }
 
+        // NOTE(Jovan): Cursor comes in window coordinates from the top left,
+        // shaders want render pixels from the bottom left like gl_FragCoord
+        r64 CursorX, CursorY;
+        i32 WindowWidth, WindowHeight;
+        glfwGetCursorPos(Window, &CursorX, &CursorY);
+        glfwGetWindowSize(Window, &WindowWidth, &WindowHeight);
+        r32 ScaleX = WindowWidth > 0 ? (r32)RenderWidth / WindowWidth : 1.0f;
+        r32 ScaleY = WindowHeight > 0 ? (r32)RenderHeight / WindowHeight : 1.0f;
+        SetUniform4f(&Uniforms, Inputs.Mouse, (r32)CursorX * ScaleX, RenderHeight - (r32)CursorY * ScaleY,
+                     (r32)(glfwGetMouseButton(Window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS),
+                     (r32)(glfwGetMouseButton(Window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS));
+        if(UseGraph) {
+            r32 PixelsX = WindowWidth > 0 ? (r32)G_WWIDTH / WindowWidth : 1.0f;
+            r32 PixelsY = WindowHeight > 0 ? (r32)G_WHEIGHT / WindowHeight : 1.0f;
+            SetRenderGraphInputs(&Graph, G_WWIDTH, G_WHEIGHT, Now, (r32)CursorX * PixelsX,
+                                 G_WHEIGHT - (r32)CursorY * PixelsY,
+                                 (r32)(glfwGetMouseButton(Window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS),
+                                 (r32)(glfwGetMouseButton(Window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS));
+            SetGraphChannels(&Graph, &Graph.Image, &Uniforms);
+        }
+
+        u32 ProgramID = GetVariantProgram(&CompileQueue, &Shader, VariantKey);
+        if(ProgramID) {
+            ProgramID = UpdateSpecialization(&CompileQueue, &Specializer, &Shader.Programs[Shader.LastKey], &Uniforms);
+        }
+        u32 HeatProgramID = UpdateHeatmap(&CompileQueue, &Heatmap, &Shader.Programs[Shader.LastKey]);
+        if(HeatProgramID) {
+            ProgramID = HeatProgramID;
+        }
+        if(ProgramID) {
+            ReflectProgramUniforms(&Uniforms, ProgramID);
+        }
+
+        if(!Animating && !G_REDRAW && ProgramID == DrawnProgramID && G_WWIDTH == DrawnWidth &&
+           G_WHEIGHT == DrawnHeight && !ReadUniformsChanged(&Uniforms) && !RenderGraphChanged(&Graph)) {
+            glfwWaitEvents();
+            continue;
+        }
+        if(!Animating) {
+            RestartFramePacing(&Pacer);
+        }
+        G_REDRAW = false;
+        SetUniform1i(&Uniforms, Inputs.Frame, (i32)FrameIndex);
+        DrawnProgramID = ProgramID;
+        DrawnWidth = G_WWIDTH;
+        DrawnHeight = G_WHEIGHT;
+        if(HeatProgramID) {
+            BeginHeatmapFrame(&Heatmap, G_WWIDTH, G_WHEIGHT);
+        }
+
+        BeginProfilerFrame(&Profiler);
+        if(UseGraph) {
+            ExecuteRenderGraph(&Graph, &Profiler, FrameIndex, VAO);
+        }
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        b32 Accumulating = Accumulator.Enabled && !HeatProgramID;
+        if(ProgramID) {
+            glUseProgram(ProgramID);
+            b32 Draw = true;
+            if(Accumulating) {
+                Draw = BeginAccumulationFrame(&Accumulator, ProgramID, &Uniforms, &Inputs, G_WWIDTH, G_WHEIGHT);
+            }
+            if(Checkering) {
+                BeginCheckerboardFrame(&Checker, ProgramID, &Uniforms, Now, G_WWIDTH, G_WHEIGHT);
+            }
+            if(Draw) {
+                UploadUniforms(&Uniforms);
+                if(UseGraph) {
+                    BindGraphInputs(&Graph, &Graph.Image);
+                }
+                // NOTE(Jovan): The heatmap isn't what anyone wants timed
+                const shader_program *Timed = HeatProgramID ? 0 :
+                                              ProgramID == Specializer.Program.ID ? &Specializer.Program :
+                                              &Shader.Programs[Shader.LastKey];
+                BeginBenchFrame(&Benchmark, Timed, Shader.LastKey, RenderWidth, RenderHeight);
+                BeginGpuPass(&Profiler, HeatProgramID ? "Heat count" : "Shader");
+                if(Scaling) {
+                    BeginScaledDraw(&DynamicResolution);
+                }
+                if(Checkering) {
+                    BeginCheckerboardDraw(&Checker, VAO);
+                }
+                glBindVertexArray(VAO);
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+                EndGpuPass(&Profiler);
+                EndBenchFrame(&Benchmark, &Shader);
+                if(Scaling) {
+                    BeginGpuPass(&Profiler, "Upscale");
+                    EndScaledDraw(&DynamicResolution, VAO);
+                    EndGpuPass(&Profiler);
+                }
+                if(Checkering) {
+                    BeginGpuPass(&Profiler, "Checker resolve");
+                    EndCheckerboardDraw(&Checker, VAO);
+                    EndGpuPass(&Profiler);
+                }
+            }
+            if(Accumulating) {
+                BeginGpuPass(&Profiler, "Accumulate");
+                EndAccumulationFrame(&Accumulator, Draw, VAO);
+                EndGpuPass(&Profiler);
+            }
+        }
+        if(HeatProgramID) {
+            BeginGpuPass(&Profiler, "Heat view");
+            EndHeatmapFrame(&Heatmap, VAO);
+            EndGpuPass(&Profiler);
+        }
+        EndProfilerFrame(&Profiler);
+
+        WaitForFrameDeadline(&Pacer);
         glfwSwapBuffers(Window);
+        ++FrameIndex;
+
+        // NOTE(Jovan): Accumulation holds time and keeps going until it
+        // converges, checkerboarding needs one more frame for the other half
+        // once things settle and compiles the worker isn't on need polling.
+        // The benchmark and specialization count frames, they'd never get
+        // there waiting for events
+        Animating = Accumulating ? !Accumulator.Converged
+                                 : UniformIsRead(&Uniforms, Inputs.Time) || UniformIsRead(&Uniforms, Inputs.Frame);
+        Animating = Animating || (UseGraph && RenderGraphAnimating(&Graph)) ||
+                    (Checkering && Checker.History != CheckerHistory_Static) ||
+                    CompileQueueBusy(&CompileQueue) || (!HeatProgramID && BenchRunning(&Benchmark)) ||
+                    (!HeatProgramID && SpecializationSettling(&Specializer, &Uniforms));
         glfwPollEvents();
     }
 
+    ShutdownFileWatcher(&Watcher);
+    glDeleteVertexArrays(1, &VAO);
+    DropSpecialization(&CompileQueue, &Specializer);
+    ShutdownHeatmap(&CompileQueue, &Heatmap);
+    ShutdownBench(&Benchmark);
+    if(Profiler.Enabled) {
+        PrintGpuProfile(&Profiler);
+    }
+    ShutdownGpuProfiler(&Profiler);
+    ShutdownAccumulator(&Accumulator);
+    ShutdownDynamicResolution(&DynamicResolution);
+    ShutdownCheckerboard(&Checker);
+    ShutdownRenderGraph(&CompileQueue, &Graph);
+    ShutdownCompileQueue(&CompileQueue);
+    DeleteVariantPrograms(&CompileQueue, &Shader);
+    if(WorkerWindow) {
+        ShutdownCompileWorker(&Worker);
+        glfwDestroyWindow(WorkerWindow);
+    }
+    ShutdownLibraryCache();
+    PrintProgramCacheStats(&G_PROGRAM_CACHE);
+
     glfwDestroyWindow(Window);
     glfwTerminate();
     return 0;
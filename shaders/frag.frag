@@ -0,0 +1,38 @@
+#version 330 core
+
+#pragma variant QUALITY LOW HIGH
+#pragma variant DEBUG_VIEW
+
+#pragma link <noise.glsl>
+
+// NOTE(Jovan): Filled in every frame, also available are "uniform int Frame"
+// and "uniform vec4 Mouse" (cursor in pixels, then left and right button).
+// FragOffset is where gl_FragCoord sits in the whole image, only tiled
+// renders move it away from zero
+uniform vec2 Resolution;
+uniform float Time;
+uniform vec2 FragOffset;
+
+// NOTE(Jovan): Motion is optional, how many pixels per second the surface
+// moves on screen. Checkerboard rendering reprojects along it, passes that
+// draw to a single target drop it
+layout(location = 0) out vec4 FragColor;
+layout(location = 1) out vec2 Motion;
+
+void main() {
+    vec2 Pixel = gl_FragCoord.xy + FragOffset;
+    vec2 UV = Pixel / Resolution;
+    vec2 P = Pixel + vec2(20.0 * Time, 0.0);
+    // NOTE(Jovan): Plain ifs on the axes so they still work as
+    // specialization constants in the SPIR-V build
+    float N = ValueNoise(P * 0.05);
+    if(QUALITY == QUALITY_HIGH) {
+        N = 0.5 * N + 0.25 * ValueNoise(P * 0.1) + 0.25 * ValueNoise(P * 0.2);
+    }
+    if(DEBUG_VIEW != 0) {
+        FragColor = vec4(vec3(N), 1.0);
+    } else {
+        FragColor = vec4(UV * N, 0.5 + 0.5 * UV.x * UV.y, 1.0);
+    }
+    Motion = vec2(-20.0, 0.0);
+}
@@ -0,0 +1,9 @@
+#version 330 core
+
+// NOTE(Jovan): One triangle big enough to cover the screen, positions come
+// from gl_VertexID so no vertex buffer is needed. Unlike a two triangle quad
+// there's no diagonal where both triangles shade the same 2x2 blocks
+void main() {
+    vec2 Position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(Position * 2.0 - 1.0, 0.0, 1.0);
+}
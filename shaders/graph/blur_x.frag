@@ -0,0 +1,17 @@
+#version 330 core
+
+uniform vec2 Resolution;
+uniform sampler2D Channel0;
+uniform vec2 ChannelResolution[4];
+
+out vec4 FragColor;
+
+// NOTE(Jovan): 9 tap gaussian folded into 5 bilinear samples
+void main() {
+    vec2 UV = gl_FragCoord.xy / Resolution;
+    vec2 Texel = vec2(1.0, 0.0) / ChannelResolution[0];
+    vec4 Sum = texture(Channel0, UV) * 0.2270270270;
+    Sum += (texture(Channel0, UV + Texel * 1.3846153846) + texture(Channel0, UV - Texel * 1.3846153846)) * 0.3162162162;
+    Sum += (texture(Channel0, UV + Texel * 3.2307692308) + texture(Channel0, UV - Texel * 3.2307692308)) * 0.0702702703;
+    FragColor = Sum;
+}
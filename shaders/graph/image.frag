@@ -0,0 +1,13 @@
+#version 330 core
+
+uniform vec2 Resolution;
+uniform sampler2D Channel0;
+uniform sampler2D Channel1;
+
+out vec4 FragColor;
+
+void main() {
+    vec2 UV = gl_FragCoord.xy / Resolution;
+    vec3 Color = texture(Channel0, UV).rgb + 2.0 * texture(Channel1, UV).rgb;
+    FragColor = vec4(Color / (1.0 + Color), 1.0);
+}
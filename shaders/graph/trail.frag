@@ -0,0 +1,18 @@
+#version 330 core
+
+// NOTE(Jovan): Channel0 is this pass itself, so last frame's trail. Holding
+// the left button steers the head with the mouse
+uniform vec2 Resolution;
+uniform float Time;
+uniform vec4 Mouse;
+uniform sampler2D Channel0;
+
+out vec4 FragColor;
+
+void main() {
+    vec2 UV = gl_FragCoord.xy / Resolution;
+    vec2 Head = Mouse.z > 0.0 ? Mouse.xy : Resolution * (0.5 + 0.35 * vec2(cos(Time * 1.3), sin(Time * 2.1)));
+    float Dot = smoothstep(12.0, 0.0, length(gl_FragCoord.xy - Head));
+    vec3 Color = 0.5 + 0.5 * cos(Time + vec3(0.0, 2.0, 4.0));
+    FragColor = vec4(texture(Channel0, UV).rgb * 0.97 + Dot * Color, 1.0);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+float Hash12(vec2 P) {
+    vec3 P3 = fract(vec3(P.xyx) * 0.1031);
+    P3 += dot(P3, P3.yzx + 33.33);
+    return fract((P3.x + P3.y) * P3.z);
+}
+
+float ValueNoise(vec2 P) {
+    vec2 I = floor(P);
+    vec2 F = fract(P);
+    vec2 U = F * F * (3.0 - 2.0 * F);
+    return mix(mix(Hash12(I + vec2(0.0, 0.0)), Hash12(I + vec2(1.0, 0.0)), U.x),
+               mix(Hash12(I + vec2(0.0, 1.0)), Hash12(I + vec2(1.0, 1.0)), U.x), U.y);
+}
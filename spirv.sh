@@ -0,0 +1,16 @@
+#! /bin/bash
+# NOTE(Jovan): Offline SPIR-V step, needs glslangValidator and a built frag.
+# Every stage under shaders/ gets a "<stage>.spv" next to it, frag loads
+# those instead of the GLSL for as long as they are newer than the source
+
+pushd build
+mkdir -p spirv
+for Shader in $(find ../shaders -name '*.vert' -o -name '*.frag' | grep -v '/include/'); do
+    Source="spirv/$(basename "$Shader")"
+    if ./frag --spirv-source "$Shader" > "$Source"; then
+        glslangValidator -G --aml --amb -S "${Shader##*.}" -o "$Shader.spv" "$Source" || rm -f "$Shader.spv"
+    else
+        rm -f "$Shader.spv"
+    fi
+done
+popd